@@ -11,9 +11,11 @@
 #include "network/PacketHandler.hpp"
 #include "network/packets/InitGamePacket.hpp"
 
+#include <array>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <enet/enet.h>
 
 namespace tetriq {
@@ -84,8 +86,10 @@ namespace tetriq {
 
             bool handle(InitGamePacket &packet) override;
             bool handle(FullGamePacket &packet) override;
+            bool handle(DeltaGamePacket &packet) override;
             bool handle(DisconnectPacket &packet) override;
             bool handle(ConnectPacket &packet) override;
+            bool handle(ServerHelloPacket &packet) override;
 
             const ClientConfig _config;
 
@@ -100,10 +104,30 @@ namespace tetriq {
             ENetAddress _address;
             ENetHost *_client;
             ENetPeer *_server;
+            /**
+             * Wire format of the connection, set by the server's hello.
+             */
+            WireFormat _wire_format{WireFormat::FIXED};
+            /**
+             * Capabilities of the connection, set by the server's hello.
+             */
+            uint64_t _capabilities{0};
 
             bool _game_started;
             std::unique_ptr<RemoteTetris> _game;
             std::vector<std::unique_ptr<ViewerTetris>> _external_games;
+            /**
+             * Players which left, network ids are never reused. Their
+             * DisconnectPacket may arrive before an InitGamePacket listing
+             * them, see TrafficClass.
+             */
+            std::unordered_set<uint64_t> _departed_players;
             std::unique_ptr<IDisplay> _display;
+
+            /**
+             * Handlers of the received packets: the client itself, then its
+             * game once it is started.
+             */
+            std::array<PacketHandler *, 2> _packet_handlers;
     };
 }
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "AConfig.hpp"
+#include "network/NetworkStream.hpp"
 
 #include <cstdint>
 #include <string>
@@ -17,5 +18,6 @@ namespace tetriq {
         uint32_t max_incoming_bandwidth = 0;
         uint32_t max_outgoing_bandwidth = 0;
         uint32_t server_timeout = 1000;
+        WireFormat wire_format = WireFormat::VARINT;
     };
 }
@@ -8,7 +8,9 @@
 #include "ITetris.hpp"
 #include "Tetris.hpp"
 #include "network/PacketHandler.hpp"
+#include "network/packets/DeltaGamePacket.hpp"
 #include "network/packets/FullGamePacket.hpp"
+#include "network/packets/GameInputPacket.hpp"
 #include "network/packets/TickGamePacket.hpp"
 #include <cstdint>
 #include <list>
@@ -19,29 +21,93 @@ namespace tetriq {
      */
     class RemoteTetris : public ITetris, public PacketHandler {
         public:
-            RemoteTetris(size_t width, size_t height, ENetPeer *peer, uint64_t player_id);
+            /**
+             * @param input_stream true to send the actions through
+             * GameInputPacket, if the server supports it.
+             * @param input_sequence sequence number of the last action sent
+             * through GameInputPacket, which carries over from game to game.
+             */
+            RemoteTetris(size_t width,
+                size_t height,
+                uint64_t seed,
+                ENetPeer *peer,
+                WireFormat wire_format,
+                uint64_t player_id,
+                bool input_stream,
+                uint64_t input_sequence);
 
             bool handleGameAction(GameAction action) override;
             uint64_t getWidth() const override;
             uint64_t getHeight() const override;
             BlockType getBlockAt(uint64_t x, uint64_t y) const override;
+            RowMask getRowMask(uint64_t y) const override;
+            uint64_t getColumnHeight(uint64_t x) const override;
             const Tetromino &getCurrentPiece() const override;
             const Tetromino &getNextPiece() const override;
-            const std::deque<BlockType> &getPowerUps() const override;
+            const PowerUps &getPowerUps() const override;
             uint64_t getPlayerId() const;
+            uint64_t getInputSequence() const;
+
+            /**
+             * Sends the actions handled since the last call in a single
+             * GameInputPacket, called once per frame.
+             */
+            void flushInput();
 
         private:
             void triggerResync();
 
+            /**
+             * Sends every action not acknowledged by the server yet.
+             */
+            void sendInput();
+
+            /**
+             * Forgets the actions the server received.
+             * @param input_sequence sequence number of the last one.
+             */
+            void acknowledgeInput(uint64_t input_sequence);
+
+            /**
+             * Rolls back to the server's state after a full or delta update
+             * and reapplies the actions the server did not handle yet.
+             */
+            void resetServerState(uint64_t applied_actions);
+
             bool handle(TestPacket &packet) override;
             bool handle(TickGamePacket &packet) override;
             bool handle(FullGamePacket &packet) override;
+            bool handle(DeltaGamePacket &packet) override;
 
             ENetPeer *_peer;
+            WireFormat _wire_format;
             uint64_t _player_id;
 
+            bool _input_stream;
+            uint64_t _input_sequence;
+            /**
+             * Actions sent through GameInputPacket and not acknowledged yet,
+             * the last one having _input_sequence.
+             */
+            GameInputPacket::Actions _unacked_actions;
+            // True if actions were handled since the last GameInputPacket
+            bool _input_pending{false};
+            // When the last GameInputPacket was sent, see enet_time_get()
+            enet_uint32 _last_input_send{0};
+
             Tetris _server_state;
+            /**
+             * The game as last broadcast by the server, which deltas are
+             * relative to.
+             */
+            Tetris _baseline;
             Tetris _client_state;
             std::list<GameAction> _predicted_actions;
+
+            /**
+             * True while waiting for the FullGamePacket requested by
+             * triggerResync().
+             */
+            bool _resync_pending{false};
     };
 }
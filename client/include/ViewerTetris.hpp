@@ -17,6 +17,7 @@ namespace tetriq {
             ViewerTetris(size_t width, size_t height, uint64_t player_id);
 
             bool handle(FullGamePacket &packet) override;
+            bool handle(DeltaGamePacket &packet) override;
             uint64_t getPlayerId() const;
 
         private:
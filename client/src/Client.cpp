@@ -10,13 +10,21 @@
 #include "RemoteTetris.hpp"
 #include "ViewerTetris.hpp"
 #include "network/PacketHandler.hpp"
+#include "network/Protocol.hpp"
+#include "network/TrafficClass.hpp"
+#include "network/packets/ClientHelloPacket.hpp"
+#include "network/packets/DeltaGamePacket.hpp"
 #include "network/packets/FullGamePacket.hpp"
 #include "network/packets/PowerUpPacket.hpp"
+#include "network/packets/ServerHelloPacket.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <span>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace tetriq {
     Client::Client(std::string ip, uint16_t port, std::unique_ptr<IDisplay> display)
@@ -27,11 +35,15 @@ namespace tetriq {
         , _game_started(false)
         , _game(nullptr)
         , _display(std::move(display))
+        , _packet_handlers{this, nullptr}
     {
         if (init() == false)
             throw ClientInitException();
-        _client = enet_host_create(
-            nullptr, 1, 0, _config.max_incoming_bandwidth, _config.max_outgoing_bandwidth);
+        _client = enet_host_create(nullptr,
+            1,
+            CHANNEL_COUNT,
+            _config.max_incoming_bandwidth,
+            _config.max_outgoing_bandwidth);
         if (_client == nullptr or not setServer())
             throw ClientInitException();
         if (not connectToServer()) {
@@ -59,14 +71,15 @@ namespace tetriq {
                     return;
                 if (!_display->handleEvents(*this))
                     return;
+                // Everything the player did during the frame goes together
+                _game->flushInput();
             }
             while (enet_host_service(_client, &_event, 0) > 0) {
                 switch (_event.type) {
                     case ENET_EVENT_TYPE_RECEIVE:
-                        if (_game_started)
-                            PacketHandler::decodePacket(_event, {this, _game.get()});
-                        else
-                            PacketHandler::decodePacket(_event, {this});
+                        PacketHandler::decodePacket(_event,
+                            std::span(_packet_handlers).first(_game_started ? 2 : 1),
+                            _wire_format);
                         break;
                     case ENET_EVENT_TYPE_DISCONNECT:
                         Logger::log(LogLevel::INFO, "Disconnected from the server");
@@ -91,9 +104,10 @@ namespace tetriq {
     void Client::sendPowerUp() const
     {
         if (targetId == 0) {
-            PowerUpPacket{getClientId()}.send(_server);
+            PowerUpPacket{getClientId()}.send(_server, _wire_format);
         } else if (targetId - 1 < _external_games.size()) {
-            PowerUpPacket{_external_games[targetId - 1]->getPlayerId()}.send(_server);
+            PowerUpPacket{_external_games[targetId - 1]->getPlayerId()}.send(
+                _server, _wire_format);
         }
     }
 
@@ -111,7 +125,8 @@ namespace tetriq {
     bool Client::connectToServer()
     {
         ENetEvent _event;
-        _server = enet_host_connect(_client, &_address, 0, 0);
+        // Tells the server we start with a handshake
+        _server = enet_host_connect(_client, &_address, CHANNEL_COUNT, PROTOCOL_VERSION);
         if (_server == nullptr) {
             return false;
         }
@@ -119,6 +134,11 @@ namespace tetriq {
             and _event.type == ENET_EVENT_TYPE_CONNECT) {
             LogLevel::INFO << "Connected to the server at address " << _server_ip << ":"
                            << _server_port << std::endl;
+            uint64_t wire_formats = 0;
+            for (uint8_t format = 1; format <= static_cast<uint8_t>(_config.wire_format); format++)
+                wire_formats |= getWireFormatFlag(static_cast<WireFormat>(format));
+            ClientHelloPacket{PROTOCOL_VERSION, wire_formats, SUPPORTED_CAPABILITIES}.send(
+                _server, WireFormat::FIXED);
             return true;
         } else {
             enet_peer_reset(_server);
@@ -139,16 +159,39 @@ namespace tetriq {
 
     bool Client::handle(InitGamePacket &packet)
     {
-        std::unique_ptr<RemoteTetris> game = std::make_unique<RemoteTetris>(
-            packet.getGameWidth(), packet.getGameHeight(), _server, packet.getPlayerId());
+        std::unique_ptr<RemoteTetris> game = std::make_unique<RemoteTetris>(packet.getGameWidth(),
+            packet.getGameHeight(),
+            packet.getSeed(),
+            _server,
+            _wire_format,
+            packet.getPlayerId(),
+            (_capabilities & CAPABILITY_INPUT_STREAM) != 0,
+            _game ? _game->getInputSequence() : 0);
         _game.swap(game);
+        _packet_handlers[1] = _game.get();
 
-        _external_games.clear();
-        _external_games.reserve(packet.getPlayerIds().size());
+        // Boards come on their own channel and may arrive before this
+        // packet, so the boards of players still there are kept, and the
+        // players which already left are not added back
+        std::vector<std::unique_ptr<ViewerTetris>> external_games;
+        external_games.reserve(packet.getPlayerIds().size());
         for (uint64_t player_id : packet.getPlayerIds()) {
-            _external_games.emplace_back(std::make_unique<ViewerTetris>(
-                packet.getGameWidth(), packet.getGameHeight(), player_id));
+            if (_departed_players.contains(player_id))
+                continue;
+            auto it = std::find_if(_external_games.begin(),
+                _external_games.end(),
+                [&](const std::unique_ptr<ViewerTetris> &tetris) {
+                    return tetris->getPlayerId() == player_id;
+                });
+            if (it != _external_games.end()
+                && (*it)->getWidth() == packet.getGameWidth()
+                && (*it)->getHeight() == packet.getGameHeight())
+                external_games.push_back(std::move(*it));
+            else
+                external_games.emplace_back(std::make_unique<ViewerTetris>(
+                    packet.getGameWidth(), packet.getGameHeight(), player_id));
         }
+        _external_games = std::move(external_games);
 
         if (_display->loadGame(*_game, packet.getPlayerIds().size())) {
             _game_started = true;
@@ -167,14 +210,35 @@ namespace tetriq {
         return false;
     }
 
+    bool Client::handle(ServerHelloPacket &packet)
+    {
+        _wire_format = packet.getWireFormat();
+        _capabilities = packet.getCapabilities();
+        LogLevel::DEBUG << "server uses protocol " << packet.getProtocolVersion()
+                        << ", wire format " << static_cast<int>(_wire_format)
+                        << " and capabilities " << packet.getCapabilities() << std::endl;
+        return true;
+    }
+
+    bool Client::handle(DeltaGamePacket &packet)
+    {
+        for (std::unique_ptr<ViewerTetris> &tetris : _external_games) {
+            if (tetris->handle(packet))
+                return true;
+        }
+        return false;
+    }
+
     bool Client::handle(DisconnectPacket &packet)
     {
+        _departed_players.insert(packet.getPlayerId());
         for (std::unique_ptr<ViewerTetris> &tetris : _external_games) {
             if (tetris->getPlayerId() == packet.getPlayerId()) {
                 _external_games.erase(
                     std::remove(_external_games.begin(), _external_games.end(), tetris),
                     _external_games.end());
-                _display->loadGame(*_game, _external_games.size());
+                if (_game)
+                    _display->loadGame(*_game, _external_games.size());
                 return true;
             }
         }
@@ -183,9 +247,16 @@ namespace tetriq {
 
     bool Client::handle(ConnectPacket &packet)
     {
+        // The InitGamePacket may have listed the player already
+        for (const std::unique_ptr<ViewerTetris> &tetris : _external_games) {
+            if (tetris->getPlayerId() == packet.getPlayerId())
+                return true;
+        }
         _external_games.emplace_back(std::make_unique<ViewerTetris>(
             packet.getGameWidth(), packet.getGameHeight(), packet.getPlayerId()));
-        _display->loadGame(*_game, _external_games.size());
+        // Before the InitGamePacket, the display is loaded once it arrives
+        if (_game)
+            _display->loadGame(*_game, _external_games.size());
         return true;
     }
 }
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: AGPL-3.0-or-later
 
 #include "ClientConfig.hpp"
+#include "Logger.hpp"
 #include <cstdint>
 #include <string>
 
@@ -14,4 +15,11 @@ tetriq::ClientConfig::ClientConfig(const std::string &config_name)
     max_outgoing_bandwidth =
         _table["max_outgoing_bandwidth"].value<int64_t>().value_or(this->max_outgoing_bandwidth);
     server_timeout = _table["server_timeout"].value<int64_t>().value_or(this->server_timeout);
+    const int64_t format =
+        _table["wire_format"].value<int64_t>().value_or(static_cast<int64_t>(wire_format));
+    if (isWireFormat(format))
+        wire_format = static_cast<WireFormat>(format);
+    else
+        LogLevel::WARNING << "unknown wire format " << format << ", using the default"
+                          << std::endl;
 }
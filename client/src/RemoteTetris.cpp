@@ -8,6 +8,8 @@
 #include "network/packets/FullGameRequestPacket.hpp"
 #include "network/packets/TestPacket.hpp"
 #include "network/packets/GameActionPacket.hpp"
+#include "network/packets/GameInputPacket.hpp"
+#include "network/packets/DeltaGamePacket.hpp"
 #include "network/packets/FullGamePacket.hpp"
 #include "network/packets/TickGamePacket.hpp"
 #include <cassert>
@@ -16,22 +18,71 @@
 #include <sys/types.h>
 
 namespace tetriq {
-    RemoteTetris::RemoteTetris(size_t width, size_t height, ENetPeer *peer, uint64_t player_id)
+    RemoteTetris::RemoteTetris(size_t width,
+        size_t height,
+        uint64_t seed,
+        ENetPeer *peer,
+        WireFormat wire_format,
+        uint64_t player_id,
+        bool input_stream,
+        uint64_t input_sequence)
         : _peer(peer)
+        , _wire_format(wire_format)
         , _player_id(player_id)
-        , _server_state(width, height)
-        , _client_state(width, height)
+        , _input_stream(input_stream)
+        , _input_sequence(input_sequence)
+        , _server_state(width, height, seed)
+        , _baseline(width, height, seed)
+        , _client_state(width, height, seed)
     {}
 
     bool RemoteTetris::handleGameAction(GameAction action)
     {
+        if (_input_stream) {
+            // The server would miss the action if the oldest one was lost
+            if (!_unacked_actions.push_back(action)) {
+                LogLevel::DEBUG << "too many actions waiting for the server" << std::endl;
+                return false;
+            }
+            _input_sequence++;
+            _input_pending = true;
+        } else {
+            GameActionPacket{action}.send(_peer, _wire_format);
+        }
         _client_state.handleGameAction(action);
-        GameActionPacket packet{action};
-        packet.send(_peer);
         _predicted_actions.push_back(action);
         return true;
     }
 
+    void RemoteTetris::flushInput()
+    {
+        if (_input_pending)
+            sendInput();
+    }
+
+    void RemoteTetris::sendInput()
+    {
+        GameInputPacket{_input_sequence, _unacked_actions}.send(
+            _peer, _wire_format, TrafficClass::INPUT);
+        _input_pending = false;
+        _last_input_send = enet_time_get();
+    }
+
+    void RemoteTetris::acknowledgeInput(uint64_t input_sequence)
+    {
+        const uint64_t first = _input_sequence - _unacked_actions.size() + 1;
+        for (uint64_t sequence = first; sequence <= input_sequence; sequence++) {
+            if (_unacked_actions.empty())
+                break;
+            _unacked_actions.pop_front();
+        }
+        // Actions sent less than a round trip ago may still be on their way,
+        // so lost input is resent at most once per round trip, on a tick
+        if (!_unacked_actions.empty()
+            && !ENET_TIME_LESS(enet_time_get(), _last_input_send + _peer->roundTripTime))
+            sendInput();
+    }
+
     bool RemoteTetris::handle(TestPacket &)
     {
         LogLevel::DEBUG << "handled test packet" << std::endl;
@@ -40,6 +91,8 @@ namespace tetriq {
 
     bool RemoteTetris::handle(TickGamePacket &packet)
     {
+        if (_input_stream)
+            acknowledgeInput(packet.getInputSequence());
         for (uint64_t i = 0; i < packet.getAppliedActions(); i++) {
             if (_predicted_actions.empty()) {
                 triggerResync();
@@ -49,6 +102,10 @@ namespace tetriq {
             _predicted_actions.pop_front();
         }
         _server_state.tick();
+        if (_server_state.getHash() != packet.getGameHash()) {
+            LogLevel::DEBUG << "game state diverged from the server" << std::endl;
+            triggerResync();
+        }
         _client_state = _server_state;
         for (GameAction action : _predicted_actions) {
             _client_state.handleGameAction(action);
@@ -60,25 +117,48 @@ namespace tetriq {
     {
         if (packet.getPlayerId() != _player_id)
             return false;
-        for (uint64_t i = 0; i < packet.getAppliedActions(); i++) {
+        _baseline = packet.getGame();
+        _resync_pending = false;
+        resetServerState(packet.getAppliedActions());
+        return true;
+    }
+
+    bool RemoteTetris::handle(DeltaGamePacket &packet)
+    {
+        if (packet.getPlayerId() != _player_id)
+            return false;
+        if (!packet.getDelta().applyTo(_baseline)) {
+            LogLevel::DEBUG << "delta does not apply to our baseline" << std::endl;
+            triggerResync();
+            return true;
+        }
+        resetServerState(packet.getAppliedActions());
+        return true;
+    }
+
+    void RemoteTetris::resetServerState(uint64_t applied_actions)
+    {
+        for (uint64_t i = 0; i < applied_actions; i++) {
             if (_predicted_actions.empty()) {
                 LogLevel::WARNING << "server applied too many actions" << std::endl;
                 break;
             }
             _predicted_actions.pop_front();
         }
-        _server_state = packet.getGame();
+        _server_state = _baseline;
         _client_state = _server_state;
         for (GameAction action : _predicted_actions) {
             _client_state.handleGameAction(action);
         }
-        return true;
     }
 
     void RemoteTetris::triggerResync()
     {
+        if (_resync_pending)
+            return;
+        _resync_pending = true;
         LogLevel::DEBUG << "resyncing with server" << std::endl;
-        FullGameRequestPacket{}.send(_peer);
+        FullGameRequestPacket{}.send(_peer, _wire_format);
     }
 
     uint64_t RemoteTetris::getWidth() const
@@ -96,6 +176,16 @@ namespace tetriq {
         return _client_state.getBlockAt(x, y);
     }
 
+    RowMask RemoteTetris::getRowMask(uint64_t y) const
+    {
+        return _client_state.getRowMask(y);
+    }
+
+    uint64_t RemoteTetris::getColumnHeight(uint64_t x) const
+    {
+        return _client_state.getColumnHeight(x);
+    }
+
     const Tetromino &RemoteTetris::getCurrentPiece() const
     {
         return _client_state.getCurrentPiece();
@@ -106,7 +196,7 @@ namespace tetriq {
         return _client_state.getNextPiece();
     }
 
-    const std::deque<BlockType> &RemoteTetris::getPowerUps() const
+    const PowerUps &RemoteTetris::getPowerUps() const
     {
         return _client_state.getPowerUps();
     }
@@ -115,4 +205,9 @@ namespace tetriq {
     {
         return _player_id;
     }
+
+    uint64_t RemoteTetris::getInputSequence() const
+    {
+        return _input_sequence;
+    }
 }
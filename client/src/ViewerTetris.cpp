@@ -5,6 +5,7 @@
 #include "ViewerTetris.hpp"
 #include "Logger.hpp"
 #include "Tetris.hpp"
+#include "network/packets/DeltaGamePacket.hpp"
 #include "network/packets/FullGamePacket.hpp"
 #include <cstdint>
 
@@ -22,6 +23,16 @@ namespace tetriq {
         return true;
     }
 
+    bool ViewerTetris::handle(DeltaGamePacket &packet)
+    {
+        if (packet.getPlayerId() != _player_id) // Packet is not for us
+            return false;
+        // Out of sync boards are fixed by the next FullGamePacket
+        if (!packet.getDelta().applyTo(*this))
+            LogLevel::DEBUG << "board of player " << _player_id << " is out of sync" << std::endl;
+        return true;
+    }
+
     uint64_t ViewerTetris::getPlayerId() const
     {
         return _player_id;
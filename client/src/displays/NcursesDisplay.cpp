@@ -265,7 +265,7 @@ void tetriq::NcursesDisplay::drawTetromino(const Tetromino &tetromino, Position
     const TetroRotation &shape = tetromino.getTetroRotation();
 
     for (int i = 0; i < 4; i++) {
-        std::tuple<char, char> local_pos = shape.at(i);
+        std::tuple<char, char> local_pos = shape.cells[i];
         unsigned int x = (position.x + std::get<0>(local_pos)) * block_size + 2; // +2 = offset x
         unsigned int y = (position.y + std::get<1>(local_pos)) * block_size + 1; // +1 = offset y
         drawBlock({x, y}, tetromino.getType(), block_size, false, colorOverride, charOverride);
@@ -221,7 +221,7 @@ void tetriq::SFMLDisplay::drawTetromino(
     const TetroRotation &shape = tetromino.getTetroRotation();
 
     for (int i = 0; i < 4; i++) {
-        std::tuple<char, char> local_pos = shape.at(i);
+        std::tuple<char, char> local_pos = shape.cells[i];
         unsigned int x = (position.x + std::get<0>(local_pos)) * block_size;
         unsigned int y = (position.y + std::get<1>(local_pos)) * block_size;
         drawBlock(sf::Vector2u(x, y), tetromino.getType(), block_size, false);
@@ -245,7 +245,7 @@ bool tetriq::SFMLDisplay::skipOverlap(
 {
     bool is_current = false;
     for (int j = 0; j < 4; j++) {
-        std::tuple<char, char> local_pos = shape.at(j);
+        std::tuple<char, char> local_pos = shape.cells[j];
         if (tempx == pos.x + std::get<0>(local_pos) && tempy == pos.y + std::get<1>(local_pos)) {
             is_current = true;
             break;
@@ -265,7 +265,7 @@ void tetriq::SFMLDisplay::drawPrediction(const ITetris &game)
     const TetroRotation &shape = current.getTetroRotation();
 
     for (int i = 0; i < 4; i++) {
-        std::tuple<char, char> local_pos = shape.at(i);
+        std::tuple<char, char> local_pos = shape.cells[i];
         unsigned int tempx = pos.x + std::get<0>(local_pos);
         unsigned int tempy = pos.y + std::get<1>(local_pos);
         unsigned int offset = 0;
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <tuple>
 #include <vector>
 #include <map>
 #include <random>
@@ -13,6 +15,7 @@
 
 namespace tetriq {
     class Tetris;
+    class Random;
 
     enum class BlockType : uint64_t {
         EMPTY,
@@ -38,15 +41,119 @@ namespace tetriq {
 
     std::string blockTypeToString(BlockType block);
 
+    /**
+     * Occupancy of one row of a board: bit x is set when the block at column
+     * x is not EMPTY.
+     */
+    using RowMask = uint32_t;
+
+    /**
+     * Widest board that can be represented with a RowMask, borders included.
+     */
+    constexpr uint64_t MAX_BOARD_WIDTH = sizeof(RowMask) * 8;
+
     using TetroShape = std::pair<BlockType, std::vector<std::vector<int>>>;
-    using TetroRotation = std::vector<std::tuple<char, char>>;
+    using TetroCells = std::array<std::tuple<char, char>, 4>;
+
+    /**
+     * One rotation of a tetromino, with its cells relative to the tetromino's
+     * position.
+     */
+    struct TetroRotation {
+            TetroCells cells;
+
+            /**
+             * Bounding box of the cells, bounds included.
+             */
+            char min_x;
+            char max_x;
+            char min_y;
+            char max_y;
+
+            /**
+             * row_masks[i] is the occupancy of row min_y + i, bit n is set
+             * when there is a cell at column min_x + n.
+             */
+            std::array<RowMask, 4> row_masks;
+
+            static constexpr TetroRotation fromCells(const TetroCells &cells)
+            {
+                TetroRotation rotation{cells, 127, -128, 127, -128, {}};
+                for (const auto &[x, y] : cells) {
+                    rotation.min_x = std::min(rotation.min_x, x);
+                    rotation.max_x = std::max(rotation.max_x, x);
+                    rotation.min_y = std::min(rotation.min_y, y);
+                    rotation.max_y = std::max(rotation.max_y, y);
+                }
+                for (const auto &[x, y] : cells)
+                    rotation.row_masks[y - rotation.min_y] |= RowMask(1) << (x - rotation.min_x);
+                return rotation;
+            }
+    };
+
+    struct TetroRotations {
+            size_t count;
+            std::array<TetroRotation, 4> rotations;
+    };
+
+    /**
+     * Rotations of every tetromino, indexed by BlockType from RED to PURPLE.
+     */
+    constexpr std::array<TetroRotations, 7> BLOCK_ROTATIONS = {{
+        // RED
+        {2,
+            {TetroRotation::fromCells({{{0, 0}, {1, 0}, {1, 1}, {2, 1}}}),
+                TetroRotation::fromCells({{{1, 0}, {0, 1}, {1, 1}, {0, 2}}})}},
+        // BLUE
+        {2,
+            {TetroRotation::fromCells({{{0, 0}, {1, 0}, {2, 0}, {3, 0}}}),
+                TetroRotation::fromCells({{{1, -1}, {1, 0}, {1, 1}, {1, 2}}})}},
+        // DARK_BLUE
+        {4,
+            {TetroRotation::fromCells({{{0, 0}, {1, 0}, {2, 0}, {2, 1}}}),
+                TetroRotation::fromCells({{{1, -1}, {1, 0}, {1, 1}, {0, 1}}}),
+                TetroRotation::fromCells({{{0, -1}, {0, 0}, {1, 0}, {2, 0}}}),
+                TetroRotation::fromCells({{{1, -1}, {2, -1}, {1, 0}, {1, 1}}})}},
+        // ORANGE
+        {4,
+            {TetroRotation::fromCells({{{0, 0}, {1, 0}, {2, 0}, {0, 1}}}),
+                TetroRotation::fromCells({{{0, -1}, {1, -1}, {1, 0}, {1, 1}}}),
+                TetroRotation::fromCells({{{2, -1}, {0, 0}, {1, 0}, {2, 0}}}),
+                TetroRotation::fromCells({{{1, -1}, {1, 0}, {1, 1}, {2, 1}}})}},
+        // YELLOW
+        {1, {TetroRotation::fromCells({{{0, 0}, {1, 0}, {0, 1}, {1, 1}}})}},
+        // GREEN
+        {2,
+            {TetroRotation::fromCells({{{1, 0}, {2, 0}, {0, 1}, {1, 1}}}),
+                TetroRotation::fromCells({{{0, 0}, {0, 1}, {1, 1}, {1, 2}}})}},
+        // PURPLE
+        {4,
+            {TetroRotation::fromCells({{{1, 0}, {0, 1}, {1, 1}, {2, 1}}}),
+                TetroRotation::fromCells({{{1, 0}, {1, 1}, {2, 1}, {1, 2}}}),
+                TetroRotation::fromCells({{{0, 1}, {1, 1}, {2, 1}, {1, 2}}}),
+                TetroRotation::fromCells({{{1, 0}, {0, 1}, {1, 1}, {1, 2}}})}},
+    }};
+
+    /**
+     * @returns true if type is the type of a tetromino.
+     */
+    constexpr bool isTetroType(BlockType type)
+    {
+        return type >= BlockType::RED && type <= BlockType::PURPLE;
+    }
 
-    extern const std::map<BlockType, std::vector<TetroRotation>> BLOCK_ROTATIONS;
+    /**
+     * @returns the rotations of a tetromino, type must be a tetromino type.
+     */
+    constexpr const TetroRotations &getTetroRotations(BlockType type)
+    {
+        return BLOCK_ROTATIONS[static_cast<size_t>(type) - static_cast<size_t>(BlockType::RED)];
+    }
 
     struct WeightedPowerUp {
             BlockType powerUp;
             uint64_t weight;
 
-            static BlockType getRandom();
+            static BlockType getRandom(Random &random);
     };
 }
@@ -8,9 +8,15 @@
 #include "GameAction.hpp"
 #include "Tetromino.hpp"
 
-#include <deque>
+#include <vector>
 
 namespace tetriq {
+    /**
+     * Power-ups held by a player, oldest first. There is no limit on how
+     * many a player holds.
+     */
+    using PowerUps = std::vector<BlockType>;
+
     class ITetris {
         public:
             virtual ~ITetris() = default;
@@ -18,9 +24,20 @@ namespace tetriq {
             virtual uint64_t getWidth() const = 0;
             virtual uint64_t getHeight() const = 0;
             virtual BlockType getBlockAt(uint64_t x, uint64_t y) const = 0;
+
+            /**
+             * @returns the occupancy mask of row y, see RowMask.
+             */
+            virtual RowMask getRowMask(uint64_t y) const = 0;
+
+            /**
+             * @returns the y of the highest block of column x below the top
+             * border, which is the bottom border if the column is empty.
+             */
+            virtual uint64_t getColumnHeight(uint64_t x) const = 0;
             virtual const Tetromino &getCurrentPiece() const = 0;
             virtual const Tetromino &getNextPiece() const = 0;
-            virtual const std::deque<BlockType> &getPowerUps() const = 0;
+            virtual const PowerUps &getPowerUps() const = 0;
 
             virtual bool handleGameAction(GameAction action) = 0;
     };
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "network/NetworkObject.hpp"
+
+#include <array>
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * @brief Seedable xoshiro256** generator. Its output only depends on the
+     * seed, so a game replayed from the same state on the client and the
+     * server draws the same numbers.
+     */
+    class Random : public NetworkObject {
+        public:
+            explicit Random(uint64_t seed = 0);
+
+            uint64_t next();
+
+            /**
+             * @returns a number in [0, bound[, bound must not be 0.
+             */
+            uint64_t nextBelow(uint64_t bound);
+
+            const std::array<uint64_t, 4> &getState() const;
+
+            NetworkOStream &operator>>(NetworkOStream &os) const override;
+            NetworkIStream &operator<<(NetworkIStream &os) override;
+            size_t getNetworkSize(WireFormat format) const override;
+
+        private:
+            std::array<uint64_t, 4> _state;
+    };
+}
@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "network/NetworkStream.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * @brief Fixed-capacity FIFO queue stored inline, it never allocates.
+     */
+    template<typename T, size_t N>
+    class RingBuffer {
+        public:
+            class ConstIterator {
+                public:
+                    ConstIterator(const RingBuffer *buffer, size_t index)
+                        : _buffer(buffer)
+                        , _index(index)
+                    {}
+
+                    const T &operator*() const
+                    {
+                        return (*_buffer)[_index];
+                    }
+
+                    const T *operator->() const
+                    {
+                        return &(*_buffer)[_index];
+                    }
+
+                    ConstIterator &operator++()
+                    {
+                        _index++;
+                        return *this;
+                    }
+
+                    bool operator==(const ConstIterator &other) const = default;
+
+                private:
+                    const RingBuffer *_buffer;
+                    size_t _index;
+            };
+
+            static constexpr size_t capacity()
+            {
+                return N;
+            }
+
+            size_t size() const
+            {
+                return _size;
+            }
+
+            bool empty() const
+            {
+                return _size == 0;
+            }
+
+            bool full() const
+            {
+                return _size == N;
+            }
+
+            T &operator[](size_t i)
+            {
+                return _items[(_head + i) % N];
+            }
+
+            const T &operator[](size_t i) const
+            {
+                return _items[(_head + i) % N];
+            }
+
+            T &front()
+            {
+                return _items[_head];
+            }
+
+            const T &front() const
+            {
+                return _items[_head];
+            }
+
+            /**
+             * @returns false if the buffer is full, in which case value is
+             * dropped.
+             */
+            bool push_back(const T &value)
+            {
+                if (full())
+                    return false;
+                _items[(_head + _size) % N] = value;
+                _size++;
+                return true;
+            }
+
+            void pop_front()
+            {
+                _head = (_head + 1) % N;
+                _size--;
+            }
+
+            void clear()
+            {
+                _head = 0;
+                _size = 0;
+            }
+
+            ConstIterator begin() const
+            {
+                return {this, 0};
+            }
+
+            ConstIterator end() const
+            {
+                return {this, _size};
+            }
+
+        private:
+            std::array<T, N> _items{};
+            size_t _head{0};
+            size_t _size{0};
+    };
+
+    template<typename T, size_t N>
+    NetworkOStream &operator>>(const RingBuffer<T, N> &value, NetworkOStream &stream)
+    {
+        uint64_t len = value.size();
+        len >> stream;
+        for (const T &v : value) {
+            v >> stream;
+        }
+        return stream;
+    }
+
+    template<typename T, size_t N>
+    size_t getWireSize(const RingBuffer<T, N> &value, WireFormat format)
+    {
+        size_t size = getWireSize(static_cast<uint64_t>(value.size()), format);
+        for (const T &v : value)
+            size += getWireSize(v, format);
+        return size;
+    }
+
+    template<typename T, size_t N>
+    NetworkIStream &operator<<(RingBuffer<T, N> &value, NetworkIStream &stream)
+    {
+        uint64_t len;
+        len << stream;
+        if (len > N)
+            throw NetworkStreamOverflowException();
+        value.clear();
+        for (uint64_t i = 0; i < len; i++) {
+            T v;
+            v << stream;
+            value.push_back(v);
+        }
+        return stream;
+    }
+}
@@ -7,28 +7,36 @@
 #include "Block.hpp"
 #include "GameAction.hpp"
 #include "ITetris.hpp"
+#include "Random.hpp"
 #include "Tetromino.hpp"
 #include "network/NetworkObject.hpp"
 
+#include <array>
 #include <cstdint>
-#include <deque>
 #include <vector>
 
 namespace tetriq {
     class Tetris : public ITetris, public NetworkObject {
+            friend class TetrisDelta;
+
         public:
-            Tetris(size_t width, size_t height);
+            /**
+             * @param seed seed of the game's random number generator, two
+             * games with the same seed and inputs evolve identically.
+             */
+            Tetris(size_t width, size_t height, uint64_t seed = 0);
             ~Tetris();
 
             uint64_t getWidth() const override;
             uint64_t getHeight() const override;
 
             BlockType getBlockAt(uint64_t x, uint64_t y) const override;
+            RowMask getRowMask(uint64_t y) const override;
+            uint64_t getColumnHeight(uint64_t x) const override;
             const Tetromino &getCurrentPiece() const override;
             const Tetromino &getNextPiece() const override;
 
-            const std::vector<Tetromino> &getNextPieces() const;
-            const std::deque<BlockType> &getPowerUps() const override;
+            const PowerUps &getPowerUps() const override;
 
             [[nodiscard]] bool moveCurrentPiece(int xOffset, int yOffset);
             [[nodiscard]] bool rotateCurrentPiece();
@@ -37,10 +45,8 @@ namespace tetriq {
             BlockType consumePowerUp();
             void applyPowerUp(BlockType powerUp);
             void clearLine(uint64_t y);
-            static void createBorders(
-                std::vector<std::vector<BlockType>> &_board, uint64_t _width, uint64_t _height);
             bool isChanged();
-            void setPowerUps(const std::deque<BlockType> &powerUps);
+            void setPowerUps(const PowerUps &powerUps);
             void setChanged(bool changed);
             void setGameOver(bool game_over);
 
@@ -52,6 +58,18 @@ namespace tetriq {
             void addGraceTicks(uint64_t n);
             uint64_t getCurrentTick() const;
 
+            /**
+             * @returns the seed the game was created with.
+             */
+            uint64_t getSeed() const;
+
+            /**
+             * @returns a hash of everything that affects how the game
+             * evolves: blocks, pieces, power-ups and random state. The
+             * blocks' part is maintained incrementally (Zobrist hashing).
+             */
+            uint64_t getHash() const;
+
             /**
              * Returns true if the game is over.
              */
@@ -59,9 +77,15 @@ namespace tetriq {
 
             NetworkOStream &operator>>(NetworkOStream &os) const override;
             NetworkIStream &operator<<(NetworkIStream &os) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
 
         private:
+            /**
+             * Version of the board encoding on the wire: blocks inside the
+             * borders, row by row, packed by a BlockPacker.
+             */
+            static constexpr uint8_t BOARD_ENCODING = 1;
+
             void doPuAddLine();
             void doPuClearLine();
             void doPuClearSpecialBlock();
@@ -70,9 +94,70 @@ namespace tetriq {
             void doPuNukeField();
             void doPuColumnShuffle();
 
+            /**
+             * Sets a block and keeps the row mask in sync. Every write to
+             * _blocks must go through this.
+             */
+            void setBlockAt(uint64_t x, uint64_t y, BlockType type);
+            void updateRowMask(uint64_t y);
+
+            /**
+             * Recomputes every column height from the row masks, used after
+             * changes that move whole rows or columns.
+             */
+            void updateColumnHeights();
+
+            /**
+             * @returns the Zobrist key of a block, EMPTY blocks have a key
+             * of 0.
+             */
+            uint64_t getBlockKey(uint64_t x, uint64_t y, BlockType type) const;
+
+            /**
+             * Recomputes _board_hash from every block.
+             */
+            void updateBoardHash();
+
+            /**
+             * Resets the board to an empty field surrounded by borders.
+             */
+            void createBorders();
+
+            /**
+             * @returns the mask of a row where every column is occupied.
+             */
+            RowMask getFullRowMask() const;
+
+            /**
+             * @returns the mask of the columns inside the borders.
+             */
+            RowMask getInnerRowMask() const;
+
+            /**
+             * @returns the number of blocks inside the borders, which are
+             * the only ones sent over the network.
+             */
+            uint64_t getInnerBlockCount() const;
+
             void moveBlocksDown(uint64_t y);
             void moveBlocksUp(uint64_t y);
 
+            /**
+             * Copies the content of row from inside the borders to row to.
+             */
+            void copyRow(uint64_t from, uint64_t to);
+
+            /**
+             * Empties row y inside the borders, without collecting power-ups.
+             */
+            void emptyRow(uint64_t y);
+
+            /**
+             * Adds the power-ups found on row y to _powerUps, from left to
+             * right.
+             */
+            void collectPowerUps(uint64_t y);
+
             bool isLineFull(uint64_t y) const;
 
             /**
@@ -80,13 +165,15 @@ namespace tetriq {
              * @return The number of blocks(!= EMPTY / INDESTRUCTIBLE) on the board.
              */
             uint64_t countBlocks() const;
-            std::vector<Position> getBlocks() const;
             bool moveBlock(Position oldPos, Position newPos);
             void placeTetromino();
             Tetromino &getCurrentPiece();
 
             /**
              * @brief Removes all full lines from the board.
+             * Surviving rows are compacted downwards in a single bottom-up
+             * sweep, and the power-ups of the removed lines are collected
+             * from top to bottom.
              * @param changed reference to a boolean that will be set to true if any lines were
              * removed.
              * @param lines_deleted reference to an unsigned int that will be incremented by the
@@ -105,9 +192,24 @@ namespace tetriq {
 
             uint64_t _width;
             uint64_t _height;
-            std::vector<std::vector<BlockType>> _blocks;
-            std::vector<Tetromino> _nextPieces;
-            std::deque<BlockType> _powerUps;
+            /**
+             * Row-major storage of the board, the block at (x, y) is at
+             * index y * _width + x.
+             */
+            std::vector<BlockType> _blocks;
+            std::vector<RowMask> _row_masks;
+            std::vector<uint64_t> _column_heights;
+            uint64_t _board_hash{0};
+            /**
+             * Ring of the upcoming pieces, starting with the current one at
+             * _current_piece.
+             */
+            std::array<Tetromino, 3> _nextPieces;
+            size_t _current_piece{0};
+            PowerUps _powerUps;
+
+            uint64_t _seed;
+            Random _random;
 
             uint64_t _tick{0};
             bool _changed{false};
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "Block.hpp"
+#include "ITetris.hpp"
+#include "Random.hpp"
+#include "Tetromino.hpp"
+#include "network/NetworkObject.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace tetriq {
+    class Tetris;
+
+    /**
+     * @brief Changes needed to turn a game into a later state of it. Only the
+     * rows that changed are stored, along with the small parts of the state
+     * (pieces, power-ups, random state...) which are always sent.
+     */
+    class TetrisDelta : public NetworkObject {
+        public:
+            TetrisDelta();
+
+            /**
+             * @param base the state the receiver is known to have.
+             * @param game the new state, with the same size as base.
+             */
+            TetrisDelta(const Tetris &base, const Tetris &game);
+
+            /**
+             * Applies the delta to a game.
+             * @returns false if the game is not in the delta's base state, in
+             * which case it is left untouched, or if the result does not
+             * match the expected state.
+             */
+            bool applyTo(Tetris &game) const;
+
+            /**
+             * @returns the number of rows that changed.
+             */
+            size_t getChangedRows() const;
+
+            NetworkOStream &operator>>(NetworkOStream &os) const override;
+            NetworkIStream &operator<<(NetworkIStream &os) override;
+            size_t getNetworkSize(WireFormat format) const override;
+
+        private:
+            uint64_t _base_hash;
+            uint64_t _hash;
+            uint64_t _width;
+            std::vector<uint64_t> _rows;
+            /**
+             * Blocks inside the borders of the changed rows, one row after
+             * the other.
+             */
+            std::vector<BlockType> _blocks;
+
+            uint64_t _grace_ticks;
+            bool _game_over;
+            std::array<Tetromino, 3> _next_pieces;
+            uint64_t _tick;
+            PowerUps _power_ups;
+            Random _random;
+    };
+}
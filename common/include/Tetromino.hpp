@@ -6,6 +6,7 @@
 
 #include "Utils.hpp"
 #include "Block.hpp"
+#include "Random.hpp"
 #include "network/NetworkObject.hpp"
 #include <cstdint>
 
@@ -14,6 +15,11 @@ namespace tetriq {
     class Tetromino : public NetworkObject {
         public:
             Tetromino();
+
+            /**
+             * Creates a tetromino of a random type at the spawn position.
+             */
+            explicit Tetromino(Random &random);
             explicit Tetromino(BlockType &&type);
             ~Tetromino();
 
@@ -31,7 +37,7 @@ namespace tetriq {
 
             NetworkOStream &operator>>(NetworkOStream &os) const override;
             NetworkIStream &operator<<(NetworkIStream &os) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
         private:
             pos _position;
             BlockType _type;
@@ -5,6 +5,7 @@
 #pragma once
 
 #include "network/NetworkStream.hpp"
+#include <cstddef>
 #include <cstdint>
 
 namespace tetriq {
@@ -17,4 +18,5 @@ namespace tetriq {
 
     NetworkOStream &operator>>(const Position &pos, NetworkOStream &os);
     NetworkIStream &operator<<(Position &pos, NetworkIStream &os);
+    size_t getWireSize(const Position &pos, WireFormat format);
 }
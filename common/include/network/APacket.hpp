@@ -6,13 +6,34 @@
 
 #include "NetworkObject.hpp"
 #include "network/PacketId.hpp"
+#include "network/TrafficClass.hpp"
 
 #include <enet/enet.h>
 
 namespace tetriq {
     class APacket : public NetworkObject {
         public:
-            void send(ENetPeer *peer) const;
+            /**
+             * @param format the wire format used by the peer's connection.
+             */
+            void send(ENetPeer *peer,
+                WireFormat format,
+                TrafficClass traffic_class = TrafficClass::GAME) const;
+
+            /**
+             * Serializes the packet, the result can be sent to any number of
+             * peers using the same wire format. ENet destroys it once every
+             * peer is done with it.
+             * @param traffic_class the packet must then be sent on the
+             * matching channel, see getChannelId().
+             */
+            ENetPacket *createENetPacket(
+                WireFormat format, TrafficClass traffic_class = TrafficClass::GAME) const;
+
+            /**
+             * @returns the size of the packet, id included, in a wire format.
+             */
+            size_t getPacketSize(WireFormat format) const;
 
             virtual PacketId getId() const = 0;
     };
@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "Block.hpp"
+#include "network/NetworkStream.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * Number of bits used by a packed block.
+     */
+    constexpr uint8_t PACKED_BLOCK_BITS = 5;
+
+    static_assert(static_cast<uint64_t>(BlockType::BLOCKTYPE_COUNT) <= 1 << PACKED_BLOCK_BITS);
+
+    /**
+     * @brief Writes blocks to a stream using PACKED_BLOCK_BITS each, starting
+     * from the most significant bits of every byte.
+     */
+    class BlockPacker {
+        public:
+            BlockPacker(NetworkOStream &stream);
+
+            void write(BlockType block);
+
+            /**
+             * Writes the last byte, padded with zeros. Must be called once
+             * every block has been written.
+             */
+            void flush();
+
+            /**
+             * @returns the number of bytes taken by count packed blocks.
+             */
+            static size_t getPackedSize(size_t count);
+
+        private:
+            NetworkOStream &_stream;
+            uint16_t _bits;
+            uint8_t _bit_count;
+    };
+
+    /**
+     * @brief Reads blocks written by a BlockPacker.
+     */
+    class BlockUnpacker {
+        public:
+            BlockUnpacker(NetworkIStream &stream);
+
+            /**
+             * @throws NetworkStreamOverflowException if the block is not a
+             * valid BlockType.
+             */
+            BlockType read();
+
+        private:
+            NetworkIStream &_stream;
+            uint16_t _bits;
+            uint8_t _bit_count;
+    };
+}
@@ -23,8 +23,9 @@ namespace tetriq {
             virtual NetworkIStream &operator<<(NetworkIStream &os) = 0;
 
             /**
-             * @returns the size of the object as it will be on the network.
+             * @returns the exact size of the object as it will be on the
+             * network in a wire format.
              */
-            virtual size_t getNetworkSize() const = 0;
+            virtual size_t getNetworkSize(WireFormat format) const = 0;
     };
 }
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 #include <deque>
@@ -16,24 +17,67 @@
 namespace tetriq {
     class NetworkStreamOverflowException : public std::exception {};
 
+    /**
+     * Encoding of the integers on the wire, chosen per connection. The value
+     * is the version of the wire format.
+     */
+    enum class WireFormat : uint8_t {
+        /**
+         * Every uint64_t is sent on 8 big-endian bytes.
+         */
+        FIXED = 1,
+        /**
+         * uint64_t are sent as LEB128 varints, 7 bits per byte with the
+         * highest bit set on every byte but the last one. Packet ids and
+         * small values take a single byte.
+         */
+        VARINT = 2,
+    };
+
+    constexpr uint8_t LATEST_WIRE_FORMAT = static_cast<uint8_t>(WireFormat::VARINT);
+
+    /**
+     * @returns true if version is a wire format this build understands.
+     */
+    bool isWireFormat(uint64_t version);
+
     /**
      * @brief Binary stream for a buffer of known size to be sent over the wire.
      * The stream should use the network endianness for all values.
      */
     class NetworkOStream {
         public:
-            NetworkOStream(size_t size);
+            NetworkOStream(size_t size, WireFormat format = WireFormat::FIXED);
+
+            /**
+             * Writes into a buffer owned by the caller, such as the data of
+             * an ENetPacket, instead of allocating one.
+             */
+            NetworkOStream(uint8_t *buf, size_t size, WireFormat format = WireFormat::FIXED);
 
             const uint8_t *getData() const;
             size_t getSize() const;
 
+            /**
+             * @returns the number of bytes written so far, at most getSize().
+             */
+            size_t getWrittenSize() const;
+
+            /**
+             * Writes a value on 8 bytes whatever the wire format, for values
+             * such as hashes which would only grow as varints.
+             */
+            void writeFixed64(uint64_t value);
+
         private:
             friend NetworkOStream &operator>>(uint64_t value, NetworkOStream &stream);
             friend NetworkOStream &operator>>(uint8_t value, NetworkOStream &stream);
 
             size_t _size;
-            std::unique_ptr<uint8_t[]> _buf;
+            std::unique_ptr<uint8_t[]> _owned_buf;
+            uint8_t *_buf;
             size_t _cursor;
+            WireFormat _format;
     };
 
     /**
@@ -42,18 +86,24 @@ namespace tetriq {
      */
     class NetworkIStream {
         public:
-            NetworkIStream(ENetPacket *packet);
+            NetworkIStream(ENetPacket *packet, WireFormat format = WireFormat::FIXED);
             ~NetworkIStream();
 
             const uint8_t *getData() const;
             size_t getSize() const;
 
+            /**
+             * Reads a value written by NetworkOStream::writeFixed64().
+             */
+            uint64_t readFixed64();
+
         private:
             friend NetworkIStream &operator<<(uint64_t &value, NetworkIStream &stream);
             friend NetworkIStream &operator<<(uint8_t &value, NetworkIStream &stream);
 
             ENetPacket *const _packet;
             size_t _cursor;
+            WireFormat _format;
     };
 
     NetworkOStream &operator>>(uint64_t value, NetworkOStream &stream);
@@ -62,6 +112,37 @@ namespace tetriq {
     NetworkIStream &operator<<(uint64_t &value, NetworkIStream &stream);
     NetworkIStream &operator<<(uint8_t &value, NetworkIStream &stream);
 
+    /**
+     * @returns the number of bytes a value takes on the wire in a format.
+     */
+    constexpr size_t getWireSize(uint64_t value, WireFormat format)
+    {
+        if (format == WireFormat::FIXED)
+            return sizeof(uint64_t);
+        // 7 bits per byte, and 0 still takes one
+        return value == 0 ? 1 : (std::bit_width(value) + 6) / 7;
+    }
+
+    constexpr size_t getWireSize(uint8_t, WireFormat)
+    {
+        return sizeof(uint8_t);
+    }
+
+    template<typename T, typename = std::enable_if<std::is_enum<T>::value, bool>::type>
+    constexpr size_t getWireSize(T value, WireFormat format)
+    {
+        return getWireSize(static_cast<typename std::underlying_type<T>::type>(value), format);
+    }
+
+    template<typename T>
+    size_t getWireSize(const std::vector<T> &value, WireFormat format)
+    {
+        size_t size = getWireSize(static_cast<uint64_t>(value.size()), format);
+        for (const T &v : value)
+            size += getWireSize(v, format);
+        return size;
+    }
+
     template<typename T, typename = std::enable_if<std::is_enum<T>::value, bool>::type>
     NetworkOStream &operator>>(T value, NetworkOStream &stream)
     {
@@ -104,6 +185,10 @@ namespace tetriq {
     {
         uint64_t len;
         len << stream;
+        // Every value takes at least a byte, a longer length is malformed and
+        // must not make us allocate
+        if (len > stream.getSize())
+            throw NetworkStreamOverflowException();
         value.clear();
         value.reserve(len);
         for (uint64_t i = 0; i < len; i++) {
@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "network/NetworkStream.hpp"
+
+#include <cstdint>
+#include <enet/enet.h>
+#include <variant>
+
+namespace tetriq {
+    /**
+     * @brief Decodes received packets into a variant, so that they can be
+     * decoded on one thread and handled on another, see PacketHandler for
+     * decoding and handling at once.
+     * @tparam Packets the packets that can be received, any other id is
+     * invalid.
+     */
+    template<class... Packets>
+    class PacketDecoder {
+        public:
+            /**
+             * Holds std::monostate for a packet which could not be decoded.
+             */
+            using Packet = std::variant<std::monostate, Packets...>;
+
+            /**
+             * Decodes a received packet, and destroys it.
+             * @returns false if its id is unknown or it is malformed, packet
+             * then holds std::monostate.
+             */
+            static bool decode(ENetPacket *epacket, WireFormat format, Packet &packet)
+            {
+                NetworkIStream stream{epacket, format};
+                try {
+                    uint64_t id;
+                    id << stream;
+                    if ((decodeAs<Packets>(id, stream, packet) || ...))
+                        return true;
+                } catch (const NetworkStreamOverflowException &) {
+                    // Malformed, the other side must not take us down
+                }
+                packet = std::monostate{};
+                return false;
+            }
+
+        private:
+            template<class P>
+            static bool decodeAs(uint64_t id, NetworkIStream &stream, Packet &packet)
+            {
+                if (id != static_cast<uint64_t>(P::ID))
+                    return false;
+                packet.template emplace<P>() << stream;
+                return true;
+            }
+    };
+}
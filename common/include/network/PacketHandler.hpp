@@ -7,12 +7,18 @@
 #include "network/packets/FullGameRequestPacket.hpp"
 #include "network/packets/TestPacket.hpp"
 #include "network/packets/GameActionPacket.hpp"
+#include "network/packets/GameInputPacket.hpp"
 #include "network/packets/InitGamePacket.hpp"
 #include "network/packets/FullGamePacket.hpp"
 #include "network/packets/TickGamePacket.hpp"
 #include "network/packets/PowerUpPacket.hpp"
 #include "network/packets/DisconnectPacket.hpp"
 #include "network/packets/ConnectPacket.hpp"
+#include "network/packets/DeltaGamePacket.hpp"
+#include "network/packets/ClientHelloPacket.hpp"
+#include "network/packets/ServerHelloPacket.hpp"
+
+#include <span>
 
 namespace tetriq {
     class PacketHandler {
@@ -20,18 +26,26 @@ namespace tetriq {
             /**
              * @brief Decodes a packet and handles it using the handlers.
              * @param event An enet event of type ENET_EVENT_TYPE_RECEIVE
+             * @param handlers Handlers tried in order until one handles the
+             * packet
+             * @param format The wire format of the connection
              */
-            static bool decodePacket(
-                const ENetEvent &event, const std::vector<PacketHandler *> &handlers);
+            static bool decodePacket(const ENetEvent &event,
+                std::span<PacketHandler *const> handlers,
+                WireFormat format);
 
             virtual bool handle(TestPacket &p);
             virtual bool handle(InitGamePacket &p);
             virtual bool handle(TickGamePacket &p);
             virtual bool handle(FullGamePacket &p);
             virtual bool handle(GameActionPacket &p);
+            virtual bool handle(GameInputPacket &p);
             virtual bool handle(FullGameRequestPacket &p);
             virtual bool handle(PowerUpPacket &p);
             virtual bool handle(DisconnectPacket &p);
             virtual bool handle(ConnectPacket &);
+            virtual bool handle(DeltaGamePacket &p);
+            virtual bool handle(ClientHelloPacket &p);
+            virtual bool handle(ServerHelloPacket &p);
     };
 }
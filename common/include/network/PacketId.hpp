@@ -22,5 +22,15 @@ namespace tetriq {
         C_POWER_UP,
         S_DISCONNECT,
         S_CONNECT,
+        S_DELTA_GAME,
+        C_GAME_INPUT,
+
+        /**
+         * Handshake packets have their own range so that adding regular
+         * packets never changes their ids. They are exchanged before the
+         * wire format is agreed on, so they always use WireFormat::FIXED.
+         */
+        C_HELLO = 0x100,
+        S_HELLO,
     };
 }
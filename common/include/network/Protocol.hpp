@@ -0,0 +1,37 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "network/NetworkStream.hpp"
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * Version of the protocol. Clients send it as the data of their ENet
+     * connection request to announce they will start with a handshake.
+     * Clients from before handshakes send 0 and are rejected, as the packets
+     * changed since without being negotiated.
+     */
+    constexpr uint64_t PROTOCOL_VERSION = 1;
+
+    /**
+     * Optional features agreed on during the handshake, as bit flags.
+     */
+    constexpr uint64_t CAPABILITY_DELTA_GAME = 1 << 0;
+    constexpr uint64_t CAPABILITY_INPUT_STREAM = 1 << 1;
+
+    /**
+     * Capabilities implemented by this build.
+     */
+    constexpr uint64_t SUPPORTED_CAPABILITIES = CAPABILITY_DELTA_GAME | CAPABILITY_INPUT_STREAM;
+
+    /**
+     * @returns the flag of a wire format in a set of wire formats.
+     */
+    constexpr uint64_t getWireFormatFlag(WireFormat format)
+    {
+        return uint64_t(1) << static_cast<uint8_t>(format);
+    }
+}
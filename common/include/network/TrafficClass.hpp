@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <enet/enet.h>
+
+namespace tetriq {
+    /**
+     * How a packet is delivered. ENet only orders packets within a channel,
+     * so the boards of the other players never hold back the player's own
+     * game and the other way around.
+     */
+    enum class TrafficClass : uint8_t {
+        // Reliable on channel 0: the handshake, the player's own game and
+        // its actions
+        GAME,
+        // Reliable on channel 1: the other players joining, leaving and
+        // updating their boards
+        BOARD,
+        // Unreliable on channel 1, for board updates superseding the previous
+        // ones. ENet drops them if they arrive after a later BOARD packet.
+        SNAPSHOT,
+        // Unreliable on channel 2, the player's actions, see GameInputPacket.
+        // Alone on their channel so that no lost reliable packet delays them.
+        INPUT,
+    };
+
+    /**
+     * Number of ENet channels used by the protocol, clients connecting with
+     * less are rejected.
+     */
+    constexpr size_t CHANNEL_COUNT = 3;
+
+    constexpr enet_uint8 getChannelId(TrafficClass traffic_class)
+    {
+        switch (traffic_class) {
+            case TrafficClass::GAME:
+                return 0;
+            case TrafficClass::BOARD:
+            case TrafficClass::SNAPSHOT:
+                return 1;
+            case TrafficClass::INPUT:
+                return 2;
+        }
+        return 0;
+    }
+
+    constexpr enet_uint32 getPacketFlags(TrafficClass traffic_class)
+    {
+        if (traffic_class == TrafficClass::SNAPSHOT || traffic_class == TrafficClass::INPUT)
+            return 0;
+        return ENET_PACKET_FLAG_RELIABLE;
+    }
+}
@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "network/APacket.hpp"
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * First packet sent by a client, with what it is able to use.
+     */
+    class ClientHelloPacket : public APacket {
+        public:
+            static constexpr PacketId ID = PacketId::C_HELLO;
+
+            ClientHelloPacket();
+            ClientHelloPacket(
+                uint64_t protocol_version, uint64_t wire_formats, uint64_t capabilities);
+
+            PacketId getId() const override;
+
+            uint64_t getProtocolVersion() const;
+
+            /**
+             * @returns the supported wire formats, see getWireFormatFlag().
+             */
+            uint64_t getWireFormats() const;
+            uint64_t getCapabilities() const;
+
+            NetworkOStream &operator>>(NetworkOStream &ns) const override;
+            NetworkIStream &operator<<(NetworkIStream &ns) override;
+            size_t getNetworkSize(WireFormat format) const override;
+
+        private:
+            uint64_t _protocol_version;
+            uint64_t _wire_formats;
+            uint64_t _capabilities;
+    };
+}
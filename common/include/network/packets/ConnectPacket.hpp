@@ -9,6 +9,8 @@
 namespace tetriq {
     class ConnectPacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::S_CONNECT;
+
             ConnectPacket();
             ConnectPacket(uint64_t player_id, uint64_t game_width, uint64_t game_height);
 
@@ -20,7 +22,7 @@ namespace tetriq {
 
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
 
         private:
             uint64_t _game_width;
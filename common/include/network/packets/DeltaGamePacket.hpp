@@ -0,0 +1,40 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "TetrisDelta.hpp"
+#include "network/APacket.hpp"
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * Update of a board relative to the last one broadcast, see TetrisDelta.
+     */
+    class DeltaGamePacket : public APacket {
+        public:
+            static constexpr PacketId ID = PacketId::S_DELTA_GAME;
+
+            DeltaGamePacket();
+            DeltaGamePacket(uint64_t player_id, const TetrisDelta &delta, uint64_t applied_actions);
+
+            PacketId getId() const override;
+
+            /**
+             * @returns which player's board this packet updates.
+             */
+            uint64_t getPlayerId() const;
+            const TetrisDelta &getDelta() const;
+            uint64_t getAppliedActions() const;
+
+            NetworkOStream &operator>>(NetworkOStream &ns) const override;
+            NetworkIStream &operator<<(NetworkIStream &ns) override;
+            size_t getNetworkSize(WireFormat format) const override;
+
+        private:
+            uint64_t _player_id;
+            TetrisDelta _delta;
+            uint64_t _applied_actions;
+    };
+}
@@ -9,6 +9,8 @@
 namespace tetriq {
     class DisconnectPacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::S_DISCONNECT;
+
             DisconnectPacket();
             DisconnectPacket(uint64_t player_id);
 
@@ -18,7 +20,7 @@ namespace tetriq {
 
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
 
         private:
             uint64_t _player_id;
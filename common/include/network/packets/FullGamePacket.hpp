@@ -11,6 +11,8 @@
 namespace tetriq {
     class FullGamePacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::S_FULL_GAME;
+
             FullGamePacket();
             FullGamePacket(uint64_t player_id, const Tetris &game, uint64_t applied_actions);
 
@@ -25,7 +27,7 @@ namespace tetriq {
 
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
 
         private:
             uint64_t _player_id;
@@ -8,9 +8,11 @@
 namespace tetriq {
     class FullGameRequestPacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::C_FULL_GAME_REQUEST;
+
             PacketId getId() const override;
             virtual NetworkOStream &operator>>(NetworkOStream &os) const override;
             virtual NetworkIStream &operator<<(NetworkIStream &os) override;
-            virtual size_t getNetworkSize() const override;
+            virtual size_t getNetworkSize(WireFormat format) const override;
     };
 }
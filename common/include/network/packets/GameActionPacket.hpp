@@ -10,6 +10,8 @@
 namespace tetriq {    
     class GameActionPacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::C_GAME_ACTION;
+
             GameActionPacket();
             GameActionPacket(GameAction action);
 
@@ -18,7 +20,7 @@ namespace tetriq {
 
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
 
         private:
             GameAction _action;
@@ -0,0 +1,54 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "GameAction.hpp"
+#include "RingBuffer.hpp"
+#include "network/APacket.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * The actions of the player not acknowledged by the server yet, sent
+     * unreliably on every new action. Actions are numbered from 1, and a lost
+     * packet is made up for by the next one.
+     */
+    class GameInputPacket : public APacket {
+        public:
+            static constexpr PacketId ID = PacketId::C_GAME_INPUT;
+
+            /**
+             * Most actions a client may have waiting for an acknowledgement.
+             */
+            static constexpr size_t MAX_ACTIONS = 32;
+
+            using Actions = RingBuffer<GameAction, MAX_ACTIONS>;
+
+            GameInputPacket();
+            GameInputPacket(uint64_t sequence, const Actions &actions);
+
+            PacketId getId() const override;
+
+            /**
+             * @returns the sequence number of the last action.
+             */
+            uint64_t getSequence() const;
+
+            /**
+             * @returns the actions in order, the last one having the packet's
+             * sequence number.
+             */
+            const Actions &getActions() const;
+
+            NetworkOStream &operator>>(NetworkOStream &ns) const override;
+            NetworkIStream &operator<<(NetworkIStream &ns) override;
+            size_t getNetworkSize(WireFormat format) const override;
+
+        private:
+            uint64_t _sequence;
+            Actions _actions;
+    };
+}
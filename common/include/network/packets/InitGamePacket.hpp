@@ -13,13 +13,20 @@
 namespace tetriq {
     class InitGamePacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::S_INIT_GAME;
+
             InitGamePacket();
-            InitGamePacket(uint64_t game_width, uint64_t game_height, uint64_t player_id, const std::vector<uint64_t> &player_ids);
+            InitGamePacket(uint64_t game_width, uint64_t game_height, uint64_t seed, uint64_t player_id, const std::vector<uint64_t> &player_ids);
 
             PacketId getId() const override;
             uint64_t getGameWidth() const;
             uint64_t getGameHeight() const;
 
+            /**
+             * @returns the seed of the player's game, see Tetris::Tetris().
+             */
+            uint64_t getSeed() const;
+
             /**
              * @returns the network id of the player.
              */
@@ -32,10 +39,11 @@ namespace tetriq {
 
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
         private:
             uint64_t _game_width;
             uint64_t _game_height;
+            uint64_t _seed;
             uint64_t _player_id;
             std::vector<uint64_t> _player_ids;
     };
@@ -11,13 +11,15 @@
 namespace tetriq {
     class PowerUpPacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::C_POWER_UP;
+
             PowerUpPacket();
             PowerUpPacket(uint64_t target);
 
             PacketId getId() const override;
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
 
             uint64_t getTarget() const;
 
@@ -0,0 +1,38 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "network/APacket.hpp"
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * Answer to a ClientHelloPacket, with what the connection will use from
+     * now on.
+     */
+    class ServerHelloPacket : public APacket {
+        public:
+            static constexpr PacketId ID = PacketId::S_HELLO;
+
+            ServerHelloPacket();
+            ServerHelloPacket(
+                uint64_t protocol_version, WireFormat wire_format, uint64_t capabilities);
+
+            PacketId getId() const override;
+
+            uint64_t getProtocolVersion() const;
+            WireFormat getWireFormat() const;
+            uint64_t getCapabilities() const;
+
+            NetworkOStream &operator>>(NetworkOStream &ns) const override;
+            NetworkIStream &operator<<(NetworkIStream &ns) override;
+            size_t getNetworkSize(WireFormat format) const override;
+
+        private:
+            uint64_t _protocol_version;
+            WireFormat _wire_format;
+            uint64_t _capabilities;
+    };
+}
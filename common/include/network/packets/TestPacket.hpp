@@ -12,12 +12,14 @@
 namespace tetriq {
     class TestPacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::TEST;
+
             TestPacket();
             PacketId getId() const override;
 
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
 
         private:
             uint64_t _magic = 0x737819;
@@ -13,20 +13,36 @@ namespace tetriq {
      */
     class TickGamePacket : public APacket {
         public:
+            static constexpr PacketId ID = PacketId::S_TICK_GAME;
+
             TickGamePacket();
-            TickGamePacket(uint64_t applied_actions);
+            TickGamePacket(uint64_t applied_actions, uint64_t game_hash, uint64_t input_sequence);
 
             PacketId getId() const override;
 
             uint64_t getAppliedActions() const;
 
+            /**
+             * @returns the hash of the game after the tick, see
+             * Tetris::getHash().
+             */
+            uint64_t getGameHash() const;
+
+            /**
+             * @returns the sequence number of the last action received through
+             * GameInputPacket, 0 from servers before it.
+             */
+            uint64_t getInputSequence() const;
+
             NetworkOStream &operator>>(NetworkOStream &ns) const override;
             NetworkIStream &operator<<(NetworkIStream &ns) override;
-            size_t getNetworkSize() const override;
+            size_t getNetworkSize(WireFormat format) const override;
         private:
             /**
              * Number of actions that have been applied.
              */
             uint64_t _applied_actions;
+            uint64_t _game_hash;
+            uint64_t _input_sequence;
     };
 }
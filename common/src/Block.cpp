@@ -3,34 +3,10 @@
 // SPDX-License-Identifier: AGPL-3.0-or-later
 
 #include "Block.hpp"
+#include "Random.hpp"
 #include <cstdint>
 
 namespace tetriq {
-    const std::map<BlockType, std::vector<TetroRotation>> BLOCK_ROTATIONS = {
-        {BlockType::YELLOW,
-            {
-                {{0, 0}, {1, 0}, {0, 1}, {1, 1}},
-            }},
-        {BlockType::DARK_BLUE,
-            {{{0, 0}, {1, 0}, {2, 0}, {2, 1}},
-                {{1, -1}, {1, 0}, {1, 1}, {0, 1}},
-                {{0, -1}, {0, 0}, {1, 0}, {2, 0}},
-                {{1, -1}, {2, -1}, {1, 0}, {1, 1}}}},
-        {BlockType::ORANGE,
-            {{{0, 0}, {1, 0}, {2, 0}, {0, 1}},
-                {{0, -1}, {1, -1}, {1, 0}, {1, 1}},
-                {{2, -1}, {0, 0}, {1, 0}, {2, 0}},
-                {{1, -1}, {1, 0}, {1, 1}, {2, 1}}}},
-        {BlockType::RED, {{{0, 0}, {1, 0}, {1, 1}, {2, 1}}, {{1, 0}, {0, 1}, {1, 1}, {0, 2}}}},
-        {BlockType::GREEN, {{{1, 0}, {2, 0}, {0, 1}, {1, 1}}, {{0, 0}, {0, 1}, {1, 1}, {1, 2}}}},
-        {BlockType::PURPLE,
-            {{{1, 0}, {0, 1}, {1, 1}, {2, 1}},
-                {{1, 0}, {1, 1}, {2, 1}, {1, 2}},
-                {{0, 1}, {1, 1}, {2, 1}, {1, 2}},
-                {{1, 0}, {0, 1}, {1, 1}, {1, 2}}}},
-        {BlockType::BLUE, {{{0, 0}, {1, 0}, {2, 0}, {3, 0}}, {{1, -1}, {1, 0}, {1, 1}, {1, 2}}}},
-    };
-
     static constexpr std::array<WeightedPowerUp, 9> powerUps = {{
         {BlockType::PU_ADD_LINE, 20},
         {BlockType::PU_CLEAR_SPECIAL_BLOCK, 14},
@@ -90,13 +66,9 @@ namespace tetriq {
         }
     }
 
-    BlockType WeightedPowerUp::getRandom()
+    BlockType WeightedPowerUp::getRandom(Random &random)
     {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_int_distribution<uint64_t> dis(0, TOTAL_POWERUPS_WEIGHT - 1);
-
-        uint64_t r = dis(gen);
+        uint64_t r = random.nextBelow(TOTAL_POWERUPS_WEIGHT);
         for (const auto &pu : powerUps) {
             if (r < pu.weight) {
                 return pu.powerUp;
@@ -35,9 +35,10 @@ const char *tetriq::Logger::levelToString(const LogLevel level)
 std::string tetriq::Logger::getTimestamp()
 {
     const time_t now = time(nullptr);
-    const tm *ltm = localtime(&now);
+    tm ltm;
+    localtime_r(&now, &ltm);
     char timestamp[20];
-    strftime(timestamp, 20, "%Y-%m-%d %H:%M:%S", ltm);
+    strftime(timestamp, 20, "%Y-%m-%d %H:%M:%S", &ltm);
     return {timestamp};
 }
 
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "Random.hpp"
+#include <bit>
+#include <cstdint>
+
+namespace tetriq {
+    Random::Random(uint64_t seed)
+    {
+        // splitmix64, so that close seeds give unrelated states
+        for (uint64_t &word : _state) {
+            seed += 0x9e3779b97f4a7c15;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    uint64_t Random::next()
+    {
+        const uint64_t result = std::rotl(_state[1] * 5, 7) * 9;
+        const uint64_t t = _state[1] << 17;
+
+        _state[2] ^= _state[0];
+        _state[3] ^= _state[1];
+        _state[1] ^= _state[2];
+        _state[0] ^= _state[3];
+        _state[2] ^= t;
+        _state[3] = std::rotl(_state[3], 45);
+        return result;
+    }
+
+    uint64_t Random::nextBelow(uint64_t bound)
+    {
+        return next() % bound;
+    }
+
+    const std::array<uint64_t, 4> &Random::getState() const
+    {
+        return _state;
+    }
+
+    NetworkOStream &Random::operator>>(NetworkOStream &os) const
+    {
+        for (uint64_t word : _state)
+            os.writeFixed64(word);
+        return os;
+    }
+
+    NetworkIStream &Random::operator<<(NetworkIStream &os)
+    {
+        for (uint64_t &word : _state)
+            word = os.readFixed64();
+        return os;
+    }
+
+    size_t Random::getNetworkSize(WireFormat) const
+    {
+        return sizeof(uint64_t) * _state.size();
+    }
+}
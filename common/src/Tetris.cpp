@@ -7,24 +7,32 @@
 #include "GameAction.hpp"
 #include "Logger.hpp"
 #include "Tetromino.hpp"
+#include "network/BlockPacker.hpp"
+#include <bit>
 #include <cstddef>
 #include <cstdint>
 
-tetriq::Tetris::Tetris(size_t width, size_t height)
+static uint64_t hashMix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+tetriq::Tetris::Tetris(size_t width, size_t height, uint64_t seed)
     : _grace_ticks(0)
     , _game_over(false)
     , _width(width)
     , _height(height)
+    , _seed(seed)
+    , _random(seed)
 {
-    for (int i = 0; i < 3; i++) {
-        _nextPieces.emplace_back();
-    }
-
-    _blocks.resize(_height);
-    for (size_t i = 0; i < _height; i++)
-        _blocks[i].resize(_width);
-
-    createBorders(_blocks, _width, _height);
+    for (Tetromino &piece : _nextPieces)
+        piece = Tetromino(_random);
+    // Enough for a full board of power-ups, so that ticks only allocate for
+    // players hoarding more
+    _powerUps.reserve(getInnerBlockCount());
+    createBorders();
 }
 
 tetriq::Tetris::~Tetris() = default;
@@ -41,27 +49,134 @@ uint64_t tetriq::Tetris::getHeight() const
 
 tetriq::BlockType tetriq::Tetris::getBlockAt(uint64_t x, uint64_t y) const
 {
-    return _blocks[y][x];
+    return _blocks[y * _width + x];
 }
 
-const tetriq::Tetromino &tetriq::Tetris::getCurrentPiece() const
+tetriq::RowMask tetriq::Tetris::getRowMask(uint64_t y) const
 {
-    return _nextPieces.front();
+    return _row_masks[y];
 }
 
-tetriq::Tetromino &tetriq::Tetris::getCurrentPiece()
+uint64_t tetriq::Tetris::getColumnHeight(uint64_t x) const
 {
-    return _nextPieces.front();
+    return _column_heights[x];
 }
 
-const tetriq::Tetromino &tetriq::Tetris::getNextPiece() const
+void tetriq::Tetris::setBlockAt(uint64_t x, uint64_t y, BlockType type)
+{
+    const RowMask bit = RowMask(1) << x;
+
+    _board_hash ^= getBlockKey(x, y, getBlockAt(x, y)) ^ getBlockKey(x, y, type);
+    _blocks[y * _width + x] = type;
+    if (type != BlockType::EMPTY) {
+        _row_masks[y] |= bit;
+        if (y != 0 && y < _column_heights[x])
+            _column_heights[x] = y;
+        return;
+    }
+    _row_masks[y] &= ~bit;
+    if (y != _column_heights[x])
+        return;
+    uint64_t height = y + 1;
+    while (height < _height - 1 && (_row_masks[height] & bit) == 0)
+        height++;
+    _column_heights[x] = height;
+}
+
+void tetriq::Tetris::updateRowMask(uint64_t y)
+{
+    RowMask mask = 0;
+    for (uint64_t x = 0; x < _width; x++) {
+        if (_blocks[y * _width + x] != BlockType::EMPTY)
+            mask |= RowMask(1) << x;
+    }
+    _row_masks[y] = mask;
+}
+
+void tetriq::Tetris::updateColumnHeights()
+{
+    RowMask seen = 0;
+
+    _column_heights.assign(_width, _height == 0 ? 0 : _height - 1);
+    for (uint64_t y = 1; y + 1 < _height; y++) {
+        RowMask found = _row_masks[y] & ~seen;
+        seen |= found;
+        for (; found != 0; found &= found - 1)
+            _column_heights[std::countr_zero(found)] = y;
+    }
+}
+
+uint64_t tetriq::Tetris::getBlockKey(uint64_t x, uint64_t y, BlockType type) const
+{
+    if (type == BlockType::EMPTY)
+        return 0;
+    return hashMix((y * _width + x) * static_cast<uint64_t>(BlockType::BLOCKTYPE_COUNT)
+                   + static_cast<uint64_t>(type) + 0x9e3779b97f4a7c15);
+}
+
+void tetriq::Tetris::updateBoardHash()
+{
+    _board_hash = 0;
+    for (uint64_t y = 0; y < _height; y++) {
+        for (uint64_t x = 0; x < _width; x++)
+            _board_hash ^= getBlockKey(x, y, getBlockAt(x, y));
+    }
+}
+
+uint64_t tetriq::Tetris::getHash() const
+{
+    uint64_t hash = _board_hash;
+
+    for (size_t i = 0; i < _nextPieces.size(); i++) {
+        const Tetromino &piece = _nextPieces[(_current_piece + i) % _nextPieces.size()];
+        hash = hashMix(hash ^ piece.getPosition().x);
+        hash = hashMix(hash ^ piece.getPosition().y);
+        hash = hashMix(hash ^ static_cast<uint64_t>(piece.getType()));
+        hash = hashMix(hash ^ piece.getRotation());
+    }
+    for (BlockType powerUp : _powerUps)
+        hash = hashMix(hash ^ static_cast<uint64_t>(powerUp));
+    hash = hashMix(hash ^ _powerUps.size());
+    for (uint64_t word : _random.getState())
+        hash = hashMix(hash ^ word);
+    hash = hashMix(hash ^ _grace_ticks);
+    return hashMix(hash ^ _game_over);
+}
+
+tetriq::RowMask tetriq::Tetris::getFullRowMask() const
+{
+    if (_width >= MAX_BOARD_WIDTH)
+        return ~RowMask(0);
+    return (RowMask(1) << _width) - 1;
+}
+
+tetriq::RowMask tetriq::Tetris::getInnerRowMask() const
+{
+    if (_width < 2)
+        return 0;
+    return getFullRowMask() & ~RowMask(1) & ~(RowMask(1) << (_width - 1));
+}
+
+uint64_t tetriq::Tetris::getInnerBlockCount() const
+{
+    if (_width < 2 || _height < 2)
+        return 0;
+    return (_width - 2) * (_height - 2);
+}
+
+const tetriq::Tetromino &tetriq::Tetris::getCurrentPiece() const
+{
+    return _nextPieces[_current_piece];
+}
+
+tetriq::Tetromino &tetriq::Tetris::getCurrentPiece()
 {
-    return _nextPieces.at(1);
+    return _nextPieces[_current_piece];
 }
 
-const std::vector<tetriq::Tetromino> &tetriq::Tetris::getNextPieces() const
+const tetriq::Tetromino &tetriq::Tetris::getNextPiece() const
 {
-    return _nextPieces;
+    return _nextPieces[(_current_piece + 1) % _nextPieces.size()];
 }
 
 bool tetriq::Tetris::moveCurrentPiece(int xOffset, int yOffset)
@@ -105,7 +220,7 @@ tetriq::BlockType tetriq::Tetris::consumePowerUp()
     if (_powerUps.empty())
         return BlockType::EMPTY;
     const BlockType powerUp = _powerUps.front();
-    _powerUps.pop_front();
+    _powerUps.erase(_powerUps.begin());
     return powerUp;
 }
 
@@ -113,11 +228,11 @@ void tetriq::Tetris::doPuAddLine()
 {
     __attribute_maybe_unused__ bool has_moved = moveCurrentPiece(0, -1);
     moveBlocksUp(_height - 2);
-    uint64_t random = rand() % (_width - 2) + 1;
+    uint64_t random = _random.nextBelow(_width - 2) + 1;
     for (uint64_t x = 1; x < _width - 1; ++x) {
-        _blocks[_height - 2][x] = BlockType::RED;
+        setBlockAt(x, _height - 2, BlockType::RED);
     }
-    _blocks[_height - 2][random] = BlockType::EMPTY;
+    setBlockAt(random, _height - 2, BlockType::EMPTY);
 }
 
 void tetriq::Tetris::doPuClearLine()
@@ -129,9 +244,11 @@ void tetriq::Tetris::doPuClearLine()
 void tetriq::Tetris::doPuClearSpecialBlock()
 {
     for (uint64_t y = 1; y < _height - 1; ++y) {
+        if ((_row_masks[y] & getInnerRowMask()) == 0)
+            continue;
         for (uint64_t x = 1; x < _width - 1; ++x) {
-            if (_blocks[y][x] > BlockType::INDESTRUCTIBLE) {
-                _blocks[y][x] = BlockType::EMPTY;
+            if (getBlockAt(x, y) > BlockType::INDESTRUCTIBLE) {
+                setBlockAt(x, y, BlockType::EMPTY);
             }
         }
     }
@@ -139,14 +256,26 @@ void tetriq::Tetris::doPuClearSpecialBlock()
 
 void tetriq::Tetris::doPuClearBlockRandom()
 {
-    auto blocks = getBlocks();
-    if (blocks.empty())
-        return;
-    uint64_t blocks_to_clear = blocks.size() * 0.3;
-    for (uint64_t i = 0; i < blocks_to_clear; i++) {
-        uint64_t random_block = rand() % blocks.size();
-        _blocks[blocks[random_block].y][blocks[random_block].x] = BlockType::EMPTY;
-        blocks.erase(blocks.begin() + random_block);
+    uint64_t blocks = 0;
+    for (uint64_t y = 1; y + 1 < _height; y++)
+        blocks += std::popcount(_row_masks[y] & getInnerRowMask());
+    uint64_t blocks_to_clear = blocks * 0.3;
+    // Picks the n-th remaining block in reading order, which is the same as
+    // removing it from a list of all the blocks.
+    for (uint64_t i = 0; i < blocks_to_clear; i++, blocks--) {
+        uint64_t random_block = _random.nextBelow(blocks);
+        for (uint64_t y = 1; y + 1 < _height; y++) {
+            RowMask row = _row_masks[y] & getInnerRowMask();
+            const uint64_t count = std::popcount(row);
+            if (random_block >= count) {
+                random_block -= count;
+                continue;
+            }
+            for (; random_block > 0; random_block--)
+                row &= row - 1;
+            setBlockAt(std::countr_zero(row), y, BlockType::EMPTY);
+            break;
+        }
     }
 }
 
@@ -154,7 +283,8 @@ void tetriq::Tetris::doPuGravity()
 {
     for (uint64_t y = _height - 2; y > 0; --y) {
         for (uint64_t x = 1; x < _width - 1; ++x) {
-            if (_blocks[y][x] != BlockType::EMPTY && _blocks[y][x] != BlockType::INDESTRUCTIBLE) {
+            if (getBlockAt(x, y) != BlockType::EMPTY
+                && getBlockAt(x, y) != BlockType::INDESTRUCTIBLE) {
                 while (moveBlock({x, y}, {x, y + 1})) {
                     y = y + 1;
                 }
@@ -167,33 +297,34 @@ void tetriq::Tetris::doPuNukeField()
 {
     for (uint64_t y = 1; y < _height - 1; ++y) {
         for (uint64_t x = 1; x < _width - 1; ++x) {
-            if (_blocks[y][x] != BlockType::INDESTRUCTIBLE) {
-                _blocks[y][x] = BlockType::EMPTY;
+            if (getBlockAt(x, y) != BlockType::INDESTRUCTIBLE) {
+                setBlockAt(x, y, BlockType::EMPTY);
             }
         }
     }
-    while (not _powerUps.empty())
-        _powerUps.pop_front();
+    _powerUps.clear();
 }
 
 void tetriq::Tetris::doPuColumnShuffle()
 {
-    static std::random_device rd;
-    static std::mt19937 g(rd());
-
-    std::vector<uint64_t> columns;
+    std::array<uint64_t, MAX_BOARD_WIDTH> columns;
     for (uint64_t i = 1; i < _width - 1; i++) {
-        columns.push_back(i);
+        columns[i - 1] = i;
+    }
+    // Fisher-Yates, std::shuffle's output depends on the standard library
+    for (uint64_t i = _width - 2; i > 1; i--) {
+        std::swap(columns[i - 1], columns[_random.nextBelow(i)]);
     }
-    std::ranges::shuffle(columns, g);
-    std::vector new_blocks(_height, std::vector(_width, BlockType::EMPTY));
-    createBorders(new_blocks, _width, _height);
+    std::array<BlockType, MAX_BOARD_WIDTH> row;
     for (uint64_t y = 1; y < _height - 1; y++) {
         for (uint64_t x = 1; x < _width - 1; x++) {
-            new_blocks[y][columns[x - 1]] = _blocks[y][x];
+            row[columns[x - 1]] = getBlockAt(x, y);
         }
+        std::copy(row.begin() + 1, row.begin() + (_width - 1), _blocks.begin() + y * _width + 1);
+        updateRowMask(y);
     }
-    _blocks = new_blocks;
+    updateColumnHeights();
+    updateBoardHash();
 }
 
 void tetriq::Tetris::applyPowerUp(BlockType powerUp)
@@ -236,11 +367,12 @@ void tetriq::Tetris::applyPowerUp(BlockType powerUp)
 void tetriq::Tetris::clearLine(uint64_t y)
 {
     for (uint64_t x = 1; x < _width - 1; ++x) {
-        if (_blocks[y][x] != BlockType::INDESTRUCTIBLE) {
-            if (_blocks[y][x] > BlockType::INDESTRUCTIBLE) {
-                _powerUps.emplace_back(_blocks[y][x]);
+        const BlockType block = getBlockAt(x, y);
+        if (block != BlockType::INDESTRUCTIBLE) {
+            if (block > BlockType::INDESTRUCTIBLE) {
+                _powerUps.push_back(block);
             }
-            _blocks[y][x] = BlockType::EMPTY;
+            setBlockAt(x, y, BlockType::EMPTY);
         }
     }
 }
@@ -263,28 +395,75 @@ void tetriq::Tetris::moveBlocksUp(uint64_t y)
     }
 }
 
+void tetriq::Tetris::copyRow(uint64_t from, uint64_t to)
+{
+    for (uint64_t x = 1; x < _width - 1; x++)
+        _board_hash ^=
+            getBlockKey(x, to, getBlockAt(x, to)) ^ getBlockKey(x, to, getBlockAt(x, from));
+    std::copy_n(_blocks.begin() + from * _width + 1, _width - 2, _blocks.begin() + to * _width + 1);
+    _row_masks[to] = _row_masks[from];
+}
+
+void tetriq::Tetris::emptyRow(uint64_t y)
+{
+    for (uint64_t x = 1; x < _width - 1; x++)
+        _board_hash ^= getBlockKey(x, y, getBlockAt(x, y));
+    std::fill_n(_blocks.begin() + y * _width + 1, _width - 2, BlockType::EMPTY);
+    _row_masks[y] &= ~getInnerRowMask();
+}
+
+void tetriq::Tetris::collectPowerUps(uint64_t y)
+{
+    for (uint64_t x = 1; x < _width - 1; ++x) {
+        if (getBlockAt(x, y) > BlockType::INDESTRUCTIBLE) {
+            _powerUps.push_back(getBlockAt(x, y));
+        }
+    }
+}
+
 void tetriq::Tetris::removeLinesFulls(bool &changed, unsigned int &lines_deleted)
 {
+    if (_height < 3)
+        return;
+
+    // Power-ups are collected from the top first, before the rows move
+    const unsigned int previous_lines_deleted = lines_deleted;
     for (uint64_t y = 1; y < _height - 1; ++y) {
         if (isLineFull(y)) {
             changed = true;
             lines_deleted++;
-            clearLine(y);
-            moveBlocksDown(y - 1);
+            collectPowerUps(y);
         }
     }
+    if (lines_deleted == previous_lines_deleted)
+        return;
+
+    uint64_t dst = _height - 2;
+    for (uint64_t y = _height - 2; y > 1; --y) {
+        if (isLineFull(y))
+            continue;
+        if (dst != y)
+            copyRow(y, dst);
+        dst--;
+    }
+    for (; dst > 1; --dst)
+        emptyRow(dst);
+
+    // The spawn row is never moved, it is only emptied when full
+    if (isLineFull(1))
+        emptyRow(1);
+    updateColumnHeights();
 }
 
 uint64_t tetriq::Tetris::getMaxHeight() const
 {
-    for (uint64_t y = 0; y < _height; y++) {
-        for (uint64_t x = 0; x < _width; x++) {
-            if (_blocks[y][x] != BlockType::EMPTY && _blocks[y][x] != BlockType::INDESTRUCTIBLE) {
-                return y;
-            }
-        }
+    // Only the borders are indestructible, so any inner block is a real block
+    uint64_t max_height = _height;
+    for (uint64_t x = 1; x + 1 < _width; x++) {
+        if (_column_heights[x] + 1 < _height)
+            max_height = std::min(max_height, _column_heights[x]);
     }
-    return _height;
+    return max_height;
 }
 
 bool tetriq::Tetris::isChanged()
@@ -294,7 +473,7 @@ bool tetriq::Tetris::isChanged()
     return changed;
 }
 
-void tetriq::Tetris::setPowerUps(const std::deque<BlockType> &powerUps)
+void tetriq::Tetris::setPowerUps(const PowerUps &powerUps)
 {
     _powerUps = powerUps;
 }
@@ -309,7 +488,7 @@ void tetriq::Tetris::setGameOver(bool game_over)
     _game_over = game_over;
 }
 
-const std::deque<tetriq::BlockType> &tetriq::Tetris::getPowerUps() const
+const tetriq::PowerUps &tetriq::Tetris::getPowerUps() const
 {
     return _powerUps;
 }
@@ -318,7 +497,8 @@ void tetriq::Tetris::tick()
 {
     unsigned int lines_deleted = 0;
     unsigned int max_height = 0;
-    std::vector<std::tuple<uint64_t, uint64_t>> blocks_in_4_next_lines;
+    std::array<Position, 5 * MAX_BOARD_WIDTH> blocks_in_4_next_lines;
+    size_t blocks_in_4_next_lines_count = 0;
     uint64_t block_on_board = 0;
 
     _tick++;
@@ -343,20 +523,21 @@ void tetriq::Tetris::tick()
     max_height = getMaxHeight();
     for (uint64_t y = max_height - 1; y < max_height + 4 && y < _height; y++) {
         for (uint64_t x = 0; x < _width; x++) {
-            if (_blocks[y][x] != BlockType::EMPTY && _blocks[y][x] < BlockType::INDESTRUCTIBLE) {
-                blocks_in_4_next_lines.emplace_back(x, y);
+            if (getBlockAt(x, y) != BlockType::EMPTY
+                && getBlockAt(x, y) < BlockType::INDESTRUCTIBLE) {
+                blocks_in_4_next_lines[blocks_in_4_next_lines_count++] = {x, y};
             }
         }
     }
-    for (unsigned int i = 0; i < lines_deleted; i++) {
-        uint64_t random_block = rand() % blocks_in_4_next_lines.size();
-        uint64_t random_block_x = std::get<0>(blocks_in_4_next_lines[random_block]);
-        uint64_t random_block_y = std::get<1>(blocks_in_4_next_lines[random_block]);
-        _blocks[random_block_y][random_block_x] = WeightedPowerUp::getRandom();
+    for (unsigned int i = 0; i < lines_deleted && blocks_in_4_next_lines_count != 0; i++) {
+        uint64_t random_block = _random.nextBelow(blocks_in_4_next_lines_count);
+        const Position &pos = blocks_in_4_next_lines[random_block];
+        setBlockAt(pos.x, pos.y, WeightedPowerUp::getRandom(_random));
         _changed = true;
-        blocks_in_4_next_lines.erase(blocks_in_4_next_lines.begin() + random_block);
-        if (blocks_in_4_next_lines.empty())
-            break;
+        std::copy(blocks_in_4_next_lines.begin() + random_block + 1,
+            blocks_in_4_next_lines.begin() + blocks_in_4_next_lines_count,
+            blocks_in_4_next_lines.begin() + random_block);
+        blocks_in_4_next_lines_count--;
     }
 }
 
@@ -373,6 +554,11 @@ uint64_t tetriq::Tetris::getCurrentTick() const
     return _tick;
 }
 
+uint64_t tetriq::Tetris::getSeed() const
+{
+    return _seed;
+}
+
 bool tetriq::Tetris::isOver() const
 {
     return _game_over;
@@ -381,18 +567,19 @@ bool tetriq::Tetris::isOver() const
 // Place the current piece on the board and generate a new one
 void tetriq::Tetris::placeTetromino()
 {
-    Tetromino &currentPiece = _nextPieces[0];
+    Tetromino &currentPiece = getCurrentPiece();
     const TetroRotation &shape = currentPiece.getTetroRotation();
 
     for (int i = 0; i < 4; i++) {
-        auto pos = shape.at(i);
+        auto pos = shape.cells[i];
         const uint64_t x = currentPiece.getPosition().x + std::get<0>(pos);
         const uint64_t y = currentPiece.getPosition().y + std::get<1>(pos);
 
-        _blocks[y][x] = currentPiece.getType();
+        setBlockAt(x, y, currentPiece.getType());
     }
-    _nextPieces.erase(_nextPieces.begin());
-    _nextPieces.emplace_back();
+    // The placed piece's slot becomes the last of the ring
+    currentPiece = Tetromino(_random);
+    _current_piece = (_current_piece + 1) % _nextPieces.size();
     if (getCurrentPiece().collides(*this)) {
         _game_over = true;
     }
@@ -404,66 +591,98 @@ tetriq::NetworkOStream &tetriq::Tetris::operator>>(tetriq::NetworkOStream &os) c
     (uint8_t) _game_over >> os;
     _width >> os;
     _height >> os;
-    _blocks >> os;
-    _nextPieces >> os;
+    BOARD_ENCODING >> os;
+    BlockPacker packer{os};
+    for (uint64_t y = 1; y + 1 < _height; y++) {
+        for (uint64_t x = 1; x + 1 < _width; x++)
+            packer.write(getBlockAt(x, y));
+    }
+    packer.flush();
+    static_cast<uint64_t>(_nextPieces.size()) >> os;
+    for (size_t i = 0; i < _nextPieces.size(); i++)
+        _nextPieces[(_current_piece + i) % _nextPieces.size()] >> os;
     _tick >> os;
     _powerUps >> os;
+    _random >> os;
     return os;
 }
 
 tetriq::NetworkIStream &tetriq::Tetris::operator<<(tetriq::NetworkIStream &os)
 {
     uint8_t game_over;
+    uint8_t encoding;
 
     _grace_ticks << os;
     game_over << os;
     _width << os;
     _height << os;
-    _blocks << os;
-    _nextPieces << os;
+    encoding << os;
+    if (_width > MAX_BOARD_WIDTH || _width < 2 || _height < 2 || encoding != BOARD_ENCODING)
+        throw NetworkStreamOverflowException();
+    // Don't allocate more than what the packet could possibly contain
+    if (BlockPacker::getPackedSize(getInnerBlockCount()) > os.getSize())
+        throw NetworkStreamOverflowException();
+    createBorders();
+    BlockUnpacker unpacker{os};
+    for (uint64_t y = 1; y + 1 < _height; y++) {
+        for (uint64_t x = 1; x + 1 < _width; x++)
+            _blocks[y * _width + x] = unpacker.read();
+    }
+    uint64_t next_pieces;
+    next_pieces << os;
+    if (next_pieces != _nextPieces.size())
+        throw NetworkStreamOverflowException();
+    for (Tetromino &piece : _nextPieces)
+        piece << os;
+    _current_piece = 0;
     _tick << os;
     _powerUps << os;
+    _random << os;
     _game_over = game_over;
+    for (uint64_t y = 0; y < _height; y++)
+        updateRowMask(y);
+    updateColumnHeights();
+    updateBoardHash();
     return os;
 }
 
-size_t tetriq::Tetris::getNetworkSize() const
+size_t tetriq::Tetris::getNetworkSize(WireFormat format) const
 {
-    size_t size = sizeof(uint64_t) * 7 + sizeof(uint8_t);
+    size_t size = getWireSize(_grace_ticks, format) + sizeof(uint8_t) + getWireSize(_width, format)
+        + getWireSize(_height, format) + sizeof(BOARD_ENCODING);
+    size += BlockPacker::getPackedSize(getInnerBlockCount());
+    size += getWireSize(static_cast<uint64_t>(_nextPieces.size()), format);
     for (const auto &tetro : _nextPieces) {
-        size += tetro.getNetworkSize();
+        size += tetro.getNetworkSize(format);
     }
-    for (const auto &type : _blocks) {
-        size += sizeof(uint64_t);
-        size += sizeof(BlockType) * type.size();
-    }
-    size += sizeof(uint64_t) * _powerUps.size();
+    size += getWireSize(_tick, format);
+    size += getWireSize(_powerUps, format);
+    size += _random.getNetworkSize(format);
     return size;
 }
 
 bool tetriq::Tetris::isLineFull(uint64_t y) const
 {
-    for (uint64_t i = 0; i < _width; i++) {
-        if (_blocks[y][i] == BlockType::EMPTY)
-            return false;
-    }
-    return true;
+    return _row_masks[y] == getFullRowMask();
 }
 
 bool tetriq::Tetris::moveBlock(Position oldPos, Position newPos)
 {
-    if (_blocks[newPos.y][newPos.x] != BlockType::EMPTY)
+    if (_row_masks[newPos.y] & (RowMask(1) << newPos.x))
         return false;
-    _blocks[newPos.y][newPos.x] = _blocks[oldPos.y][oldPos.x];
-    _blocks[oldPos.y][oldPos.x] = BlockType::EMPTY;
+    setBlockAt(newPos.x, newPos.y, getBlockAt(oldPos.x, oldPos.y));
+    setBlockAt(oldPos.x, oldPos.y, BlockType::EMPTY);
     return true;
 }
 
 uint64_t tetriq::Tetris::countBlocks() const
 {
     uint64_t count = 0;
-    for (const auto &row : _blocks) {
-        for (const auto &block : row) {
+    for (uint64_t y = 0; y < _height; y++) {
+        if ((_row_masks[y] & getInnerRowMask()) == 0)
+            continue;
+        for (uint64_t x = 1; x < _width - 1; x++) {
+            const BlockType block = getBlockAt(x, y);
             if (block != BlockType::EMPTY && block < BlockType::INDESTRUCTIBLE) {
                 count++;
             }
@@ -472,28 +691,17 @@ uint64_t tetriq::Tetris::countBlocks() const
     return count;
 }
 
-std::vector<tetriq::Position> tetriq::Tetris::getBlocks() const
+void tetriq::Tetris::createBorders()
 {
-    std::vector<Position> blocks;
+    _blocks.assign(_width * _height, BlockType::EMPTY);
+    _row_masks.assign(_height, 0);
+    _column_heights.assign(_width, 0);
+    _board_hash = 0;
     for (uint64_t y = 0; y < _height; y++) {
         for (uint64_t x = 0; x < _width; x++) {
-            if (_blocks[y][x] != BlockType::EMPTY && _blocks[y][x] != BlockType::INDESTRUCTIBLE) {
-                blocks.emplace_back(x, y);
-            }
-        }
-    }
-    return blocks;
-}
-
-void tetriq::Tetris::createBorders(
-    std::vector<std::vector<BlockType>> &_board, uint64_t width, uint64_t height)
-{
-    for (size_t i = 0; i < height; i++) {
-        for (size_t j = 0; j < width; j++) {
-            if (j == 0 || j == width - 1 || i == height - 1 || i == 0)
-                _board[i][j] = BlockType::INDESTRUCTIBLE;
-            else
-                _board[i][j] = BlockType::EMPTY;
+            if (x == 0 || x == _width - 1 || y == _height - 1 || y == 0)
+                setBlockAt(x, y, BlockType::INDESTRUCTIBLE);
         }
     }
+    updateColumnHeights();
 }
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "TetrisDelta.hpp"
+#include "Tetris.hpp"
+#include "network/BlockPacker.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace tetriq {
+    TetrisDelta::TetrisDelta()
+        : _base_hash(0)
+        , _hash(0)
+        , _width(0)
+        , _grace_ticks(0)
+        , _game_over(false)
+        , _tick(0)
+    {}
+
+    TetrisDelta::TetrisDelta(const Tetris &base, const Tetris &game)
+        : _base_hash(base.getHash())
+        , _hash(game.getHash())
+        , _width(game._width)
+        , _grace_ticks(game._grace_ticks)
+        , _game_over(game._game_over)
+        , _tick(game._tick)
+        , _power_ups(game._powerUps)
+        , _random(game._random)
+    {
+        // Borders never change, only the inside of the rows is compared
+        for (uint64_t y = 1; y + 1 < game._height; y++) {
+            auto row = game._blocks.begin() + y * _width + 1;
+            if (base._row_masks[y] == game._row_masks[y]
+                && std::equal(row, row + _width - 2, base._blocks.begin() + y * _width + 1))
+                continue;
+            _rows.push_back(y);
+            _blocks.insert(_blocks.end(), row, row + _width - 2);
+        }
+        for (size_t i = 0; i < _next_pieces.size(); i++)
+            _next_pieces[i] = game._nextPieces[(game._current_piece + i) % _next_pieces.size()];
+    }
+
+    bool TetrisDelta::applyTo(Tetris &game) const
+    {
+        if (game.getHash() != _base_hash || game._width != _width)
+            return false;
+        for (uint64_t y : _rows) {
+            if (y == 0 || y + 1 >= game._height)
+                return false;
+        }
+        for (size_t i = 0; i < _rows.size(); i++) {
+            for (uint64_t x = 1; x + 1 < _width; x++)
+                game.setBlockAt(x, _rows[i], _blocks[i * (_width - 2) + x - 1]);
+        }
+        game._grace_ticks = _grace_ticks;
+        game._game_over = _game_over;
+        game._nextPieces = _next_pieces;
+        game._current_piece = 0;
+        game._tick = _tick;
+        game._powerUps = _power_ups;
+        game._random = _random;
+        return game.getHash() == _hash;
+    }
+
+    size_t TetrisDelta::getChangedRows() const
+    {
+        return _rows.size();
+    }
+
+    NetworkOStream &TetrisDelta::operator>>(NetworkOStream &os) const
+    {
+        os.writeFixed64(_base_hash);
+        os.writeFixed64(_hash);
+        _width >> os;
+        _rows >> os;
+        BlockPacker packer{os};
+        for (BlockType block : _blocks)
+            packer.write(block);
+        packer.flush();
+        _grace_ticks >> os;
+        (uint8_t) _game_over >> os;
+        for (const Tetromino &piece : _next_pieces)
+            piece >> os;
+        _tick >> os;
+        _power_ups >> os;
+        _random >> os;
+        return os;
+    }
+
+    NetworkIStream &TetrisDelta::operator<<(NetworkIStream &os)
+    {
+        uint8_t game_over;
+
+        _base_hash = os.readFixed64();
+        _hash = os.readFixed64();
+        _width << os;
+        if (_width < 2 || _width > MAX_BOARD_WIDTH)
+            throw NetworkStreamOverflowException();
+        _rows << os;
+        if (_rows.size() * (_width - 2) > os.getSize())
+            throw NetworkStreamOverflowException();
+        _blocks.resize(_rows.size() * (_width - 2));
+        BlockUnpacker unpacker{os};
+        for (BlockType &block : _blocks)
+            block = unpacker.read();
+        _grace_ticks << os;
+        game_over << os;
+        for (Tetromino &piece : _next_pieces)
+            piece << os;
+        _tick << os;
+        _power_ups << os;
+        _random << os;
+        _game_over = game_over;
+        return os;
+    }
+
+    size_t TetrisDelta::getNetworkSize(WireFormat format) const
+    {
+        size_t size = sizeof(_base_hash) + sizeof(_hash) + getWireSize(_width, format);
+        size += getWireSize(_rows, format);
+        size += BlockPacker::getPackedSize(_blocks.size());
+        size += getWireSize(_grace_ticks, format) + sizeof(uint8_t);
+        for (const Tetromino &piece : _next_pieces)
+            size += piece.getNetworkSize(format);
+        size += getWireSize(_tick, format);
+        size += getWireSize(_power_ups, format);
+        size += _random.getNetworkSize(format);
+        return size;
+    }
+}
@@ -9,10 +9,15 @@
 #include <cstdint>
 #include <tuple>
 
-// create a tetromino at x=4 y=0 && with a random shape
 tetriq::Tetromino::Tetromino()
     : _position({4, 1})
-    , _type(static_cast<BlockType>(rand() % 7 + 1))
+    , _type(BlockType::RED)
+{}
+
+// create a tetromino at x=4 y=1 && with a random shape
+tetriq::Tetromino::Tetromino(Random &random)
+    : _position({4, 1})
+    , _type(static_cast<BlockType>(random.nextBelow(7) + 1))
 {}
 
 tetriq::Tetromino::Tetromino(BlockType &&type)
@@ -51,7 +56,7 @@ void tetriq::Tetromino::setPosition(pos position)
 
 const tetriq::TetroRotation &tetriq::Tetromino::getTetroRotation() const
 {
-    return BLOCK_ROTATIONS.at(getType()).at(getRotation());
+    return getTetroRotations(_type).rotations[_rotation];
 }
 
 bool tetriq::Tetromino::move(int xOffset, int yOffset, const ITetris &game)
@@ -69,7 +74,7 @@ bool tetriq::Tetromino::move(int xOffset, int yOffset, const ITetris &game)
 bool tetriq::Tetromino::rotate(const ITetris &game)
 {
     Tetromino next = *this;
-    next._rotation = (_rotation + 1) % BLOCK_ROTATIONS.at(_type).size();
+    next._rotation = (_rotation + 1) % getTetroRotations(_type).count;
     if (next.collides(game))
         return false;
 
@@ -79,21 +84,35 @@ bool tetriq::Tetromino::rotate(const ITetris &game)
 
 void tetriq::Tetromino::drop(ITetris &game)
 {
-    while (move(0, 1, game)) {}
+    const TetroRotation &shape = getTetroRotation();
+    uint64_t distance = game.getHeight();
+
+    for (const auto &[local_x, local_y] : shape.cells) {
+        const uint64_t x = _position.x + local_x;
+        const uint64_t y = _position.y + local_y;
+        const uint64_t height = game.getColumnHeight(x);
+        // The piece was moved under an overhang, the heights can't help
+        if (height <= y) {
+            while (move(0, 1, game)) {}
+            return;
+        }
+        distance = std::min(distance, height - y - 1);
+    }
+    _position.y += distance;
     // game.addGraceTicks(1);
 }
 
 bool tetriq::Tetromino::collides(const ITetris &game) const
 {
     const TetroRotation &shape = getTetroRotation();
-    for (int i = 0; i < 4; i++) {
-        const std::tuple<char, char> &local_pos = shape.at(i);
-        int x = _position.x + std::get<0>(local_pos);
-        int y = _position.y + std::get<1>(local_pos);
-        if (x < 0 || x >= static_cast<int>(game.getWidth())
-            || y >= static_cast<int>(game.getHeight()))
+    const int left = _position.x + shape.min_x;
+    if (left < 0 || _position.x + shape.max_x >= game.getWidth())
+        return true;
+    for (int i = 0; i <= shape.max_y - shape.min_y; i++) {
+        int y = _position.y + shape.min_y + i;
+        if (y < 0 || y >= static_cast<int>(game.getHeight()))
             return true;
-        if (game.getBlockAt(x, y) != BlockType::EMPTY)
+        if (game.getRowMask(y) & (shape.row_masks[i] << left))
             return true;
     }
     return false;
@@ -112,10 +131,13 @@ tetriq::NetworkIStream &tetriq::Tetromino::operator<<(tetriq::NetworkIStream &os
     _position << os;
     _type << os;
     _rotation << os;
+    if (!isTetroType(_type) || _rotation >= getTetroRotations(_type).count)
+        throw NetworkStreamOverflowException();
     return os;
 }
 
-size_t tetriq::Tetromino::getNetworkSize() const
+size_t tetriq::Tetromino::getNetworkSize(WireFormat format) const
 {
-    return sizeof(uint64_t) * 4;
+    return getWireSize(_position, format) + getWireSize(_type, format)
+        + getWireSize(_rotation, format);
 }
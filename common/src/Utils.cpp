@@ -18,4 +18,9 @@ namespace tetriq {
         pos.y << os;
         return os;
     }
+
+    size_t getWireSize(const Position &pos, WireFormat format)
+    {
+        return getWireSize(pos.x, format) + getWireSize(pos.y, format);
+    }
 }
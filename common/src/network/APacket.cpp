@@ -3,17 +3,36 @@
 // SPDX-License-Identifier: AGPL-3.0-or-later
 
 #include "network/APacket.hpp"
+#include <cassert>
+#include <cstddef>
 
 namespace tetriq {
-    void APacket::send(ENetPeer *peer) const
+    void APacket::send(ENetPeer *peer, WireFormat format, TrafficClass traffic_class) const
     {
-        NetworkOStream stream{sizeof(uint64_t) + getNetworkSize()};
-
-        getId() >> stream;
-        *this >> stream;
+        enet_peer_send(
+            peer, getChannelId(traffic_class), createENetPacket(format, traffic_class));
+    }
 
+    ENetPacket *APacket::createENetPacket(WireFormat format, TrafficClass traffic_class) const
+    {
+        // Without data, ENet only allocates the buffer and we serialize in it
         ENetPacket *epacket =
-            enet_packet_create(stream.getData(), stream.getSize(), ENET_PACKET_FLAG_RELIABLE);
-        enet_peer_send(peer, 0, epacket);
+            enet_packet_create(nullptr, getPacketSize(format), getPacketFlags(traffic_class));
+        NetworkOStream stream{epacket->data, epacket->dataLength, format};
+
+        try {
+            getId() >> stream;
+            *this >> stream;
+        } catch (const NetworkStreamOverflowException &) {
+            enet_packet_destroy(epacket);
+            throw;
+        }
+        assert(stream.getWrittenSize() == epacket->dataLength);
+        return epacket;
+    }
+
+    size_t APacket::getPacketSize(WireFormat format) const
+    {
+        return getWireSize(getId(), format) + getNetworkSize(format);
     }
 }
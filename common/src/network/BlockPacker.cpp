@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "network/BlockPacker.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace tetriq {
+    BlockPacker::BlockPacker(NetworkOStream &stream)
+        : _stream(stream)
+        , _bits(0)
+        , _bit_count(0)
+    {}
+
+    void BlockPacker::write(BlockType block)
+    {
+        _bits = (_bits << PACKED_BLOCK_BITS) | static_cast<uint16_t>(block);
+        _bit_count += PACKED_BLOCK_BITS;
+        if (_bit_count >= 8) {
+            _bit_count -= 8;
+            static_cast<uint8_t>(_bits >> _bit_count) >> _stream;
+        }
+    }
+
+    void BlockPacker::flush()
+    {
+        if (_bit_count != 0)
+            static_cast<uint8_t>(_bits << (8 - _bit_count)) >> _stream;
+        _bits = 0;
+        _bit_count = 0;
+    }
+
+    size_t BlockPacker::getPackedSize(size_t count)
+    {
+        return (count * PACKED_BLOCK_BITS + 7) / 8;
+    }
+
+    BlockUnpacker::BlockUnpacker(NetworkIStream &stream)
+        : _stream(stream)
+        , _bits(0)
+        , _bit_count(0)
+    {}
+
+    BlockType BlockUnpacker::read()
+    {
+        if (_bit_count < PACKED_BLOCK_BITS) {
+            uint8_t byte;
+            byte << _stream;
+            _bits = (_bits << 8) | byte;
+            _bit_count += 8;
+        }
+        _bit_count -= PACKED_BLOCK_BITS;
+        const uint16_t block = (_bits >> _bit_count) & ((1 << PACKED_BLOCK_BITS) - 1);
+        if (block >= static_cast<uint16_t>(BlockType::BLOCKTYPE_COUNT))
+            throw NetworkStreamOverflowException();
+        return static_cast<BlockType>(block);
+    }
+}
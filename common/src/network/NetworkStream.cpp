@@ -10,10 +10,24 @@
 
 namespace tetriq {
 
-    NetworkOStream::NetworkOStream(size_t size)
+    bool isWireFormat(uint64_t version)
+    {
+        return version >= static_cast<uint8_t>(WireFormat::FIXED) && version <= LATEST_WIRE_FORMAT;
+    }
+
+    NetworkOStream::NetworkOStream(size_t size, WireFormat format)
         : _size(size)
-        , _buf(new uint8_t[size])
+        , _owned_buf(new uint8_t[size])
+        , _buf(_owned_buf.get())
         , _cursor(0)
+        , _format(format)
+    {}
+
+    NetworkOStream::NetworkOStream(uint8_t *buf, size_t size, WireFormat format)
+        : _size(size)
+        , _buf(buf)
+        , _cursor(0)
+        , _format(format)
     {}
 
     const uint8_t *NetworkOStream::getData() const
@@ -22,7 +36,7 @@ namespace tetriq {
             LogLevel::WARNING
                 << "NetworkOStream was not completely filled before getting its data (" << _cursor
                 << "/" << _size << " bytes)" << std::endl;
-        return _buf.get();
+        return _buf;
     }
 
     size_t NetworkOStream::getSize() const
@@ -30,27 +44,46 @@ namespace tetriq {
         return _size;
     }
 
-    NetworkOStream &operator>>(uint64_t value, NetworkOStream &stream)
+    size_t NetworkOStream::getWrittenSize() const
+    {
+        return _cursor;
+    }
+
+    void NetworkOStream::writeFixed64(uint64_t value)
     {
-        if (stream._cursor > stream._size - sizeof(uint64_t))
+        if (_cursor + sizeof(uint64_t) > _size)
             throw NetworkStreamOverflowException();
-        *(uint64_t *) &stream._buf[stream._cursor] = htobe64(value);
-        stream._cursor += sizeof(uint64_t);
+        *(uint64_t *) &_buf[_cursor] = htobe64(value);
+        _cursor += sizeof(uint64_t);
+    }
+
+    NetworkOStream &operator>>(uint64_t value, NetworkOStream &stream)
+    {
+        if (stream._format == WireFormat::FIXED) {
+            stream.writeFixed64(value);
+            return stream;
+        }
+        while (value >= 0x80) {
+            static_cast<uint8_t>(value | 0x80) >> stream;
+            value >>= 7;
+        }
+        static_cast<uint8_t>(value) >> stream;
         return stream;
     }
 
     NetworkOStream &operator>>(uint8_t value, NetworkOStream &stream)
     {
-        if (stream._cursor > stream._size - sizeof(uint8_t))
+        if (stream._cursor + sizeof(uint8_t) > stream._size)
             throw NetworkStreamOverflowException();
-        *(uint8_t *) &stream._buf[stream._cursor] = htobe64(value);
+        stream._buf[stream._cursor] = value;
         stream._cursor += sizeof(uint8_t);
         return stream;
     }
 
-    NetworkIStream::NetworkIStream(ENetPacket *packet)
+    NetworkIStream::NetworkIStream(ENetPacket *packet, WireFormat format)
         : _packet(packet)
         , _cursor(0)
+        , _format(format)
     {}
 
     NetworkIStream::~NetworkIStream()
@@ -68,20 +101,39 @@ namespace tetriq {
         return _packet->dataLength;
     }
 
-    NetworkIStream &operator<<(uint64_t &value, NetworkIStream &stream)
+    uint64_t NetworkIStream::readFixed64()
     {
-        if (stream._cursor > stream._packet->dataLength - sizeof(uint64_t))
+        if (_cursor + sizeof(uint64_t) > _packet->dataLength)
             throw NetworkStreamOverflowException();
-        value = be64toh(*(uint64_t *) &stream._packet->data[stream._cursor]);
-        stream._cursor += sizeof(uint64_t);
-        return stream;
+        uint64_t value = be64toh(*(uint64_t *) &_packet->data[_cursor]);
+        _cursor += sizeof(uint64_t);
+        return value;
+    }
+
+    NetworkIStream &operator<<(uint64_t &value, NetworkIStream &stream)
+    {
+        if (stream._format == WireFormat::FIXED) {
+            value = stream.readFixed64();
+            return stream;
+        }
+        value = 0;
+        for (unsigned int shift = 0;; shift += 7) {
+            uint8_t byte;
+            byte << stream;
+            // The 10th byte can only hold the highest bit of a uint64_t
+            if (shift == 63 && byte > 1)
+                throw NetworkStreamOverflowException();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0)
+                return stream;
+        }
     }
 
     NetworkIStream &operator<<(uint8_t &value, NetworkIStream &stream)
     {
-        if (stream._cursor > stream._packet->dataLength - sizeof(uint8_t))
+        if (stream._cursor + sizeof(uint8_t) > stream._packet->dataLength)
             throw NetworkStreamOverflowException();
-        value = be64toh(*(uint8_t *) &stream._packet->data[stream._cursor]);
+        value = stream._packet->data[stream._cursor];
         stream._cursor += sizeof(uint8_t);
         return stream;
     }
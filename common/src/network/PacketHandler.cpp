@@ -8,11 +8,17 @@
 #include "network/packets/GameActionPacket.hpp"
 #include "network/packets/InitGamePacket.hpp"
 #include "network/packets/FullGamePacket.hpp"
+#include "network/packets/DeltaGamePacket.hpp"
 #include "network/packets/TickGamePacket.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
 
 namespace tetriq {
+    using DecodeFunction = bool (*)(std::span<PacketHandler *const>, NetworkIStream &);
+
     template<class P>
-    static bool handlePacket(const std::vector<PacketHandler *> &handlers, NetworkIStream &stream)
+    static bool handlePacket(std::span<PacketHandler *const> handlers, NetworkIStream &stream)
     {
         P packet;
         packet << stream;
@@ -24,35 +30,88 @@ namespace tetriq {
         return false;
     }
 
+    /**
+     * @brief Compile-time list of the packets that can be received, from
+     * which the dispatch tables are built.
+     */
+    template<class... Packets>
+    struct PacketRegistry {
+        /**
+         * @returns the size of the table for the ids in [first, limit).
+         */
+        static consteval size_t getTableSize(uint64_t first, uint64_t limit)
+        {
+            size_t size = 0;
+            for (uint64_t id : {static_cast<uint64_t>(Packets::ID)...}) {
+                if (id >= first && id < limit)
+                    size = std::max<size_t>(size, id - first + 1);
+            }
+            return size;
+        }
+
+        /**
+         * @returns the decoding function of each id in [First, Limit), at
+         * index id - First. Unknown ids have no function.
+         */
+        template<uint64_t First, uint64_t Limit>
+        static consteval std::array<DecodeFunction, getTableSize(First, Limit)> makeTable()
+        {
+            std::array<DecodeFunction, getTableSize(First, Limit)> table{};
+            auto add = [&table](uint64_t id, DecodeFunction decode) {
+                if (id < First || id >= Limit)
+                    return;
+                if (table[id - First] != nullptr)
+                    throw "two packets have the same id";
+                table[id - First] = decode;
+            };
+            (add(static_cast<uint64_t>(Packets::ID), &handlePacket<Packets>), ...);
+            return table;
+        }
+    };
+
+    using Packets = PacketRegistry<TestPacket,
+        InitGamePacket,
+        TickGamePacket,
+        FullGamePacket,
+        GameActionPacket,
+        FullGameRequestPacket,
+        PowerUpPacket,
+        DisconnectPacket,
+        ConnectPacket,
+        DeltaGamePacket,
+        GameInputPacket,
+        ClientHelloPacket,
+        ServerHelloPacket>;
+
+    static constexpr uint64_t HANDSHAKE_IDS = static_cast<uint64_t>(PacketId::C_HELLO);
+    static constexpr auto PACKET_DECODERS = Packets::makeTable<0, HANDSHAKE_IDS>();
+    static constexpr auto HANDSHAKE_DECODERS =
+        Packets::makeTable<HANDSHAKE_IDS, HANDSHAKE_IDS * 2>();
+
     bool PacketHandler::decodePacket(
-        const ENetEvent &event, const std::vector<PacketHandler *> &handlers)
+        const ENetEvent &event, std::span<PacketHandler *const> handlers, WireFormat format)
     {
-        NetworkIStream stream{event.packet};
+        NetworkIStream stream{event.packet, format};
         uint64_t id{0};
-        id << stream;
-        switch (static_cast<PacketId>(id)) {
-            case PacketId::TEST:
-                return handlePacket<TestPacket>(handlers, stream);
-            case PacketId::S_INIT_GAME:
-                return handlePacket<InitGamePacket>(handlers, stream);
-            case PacketId::S_TICK_GAME:
-                return handlePacket<TickGamePacket>(handlers, stream);
-            case PacketId::S_FULL_GAME:
-                return handlePacket<FullGamePacket>(handlers, stream);
-            case PacketId::C_GAME_ACTION:
-                return handlePacket<GameActionPacket>(handlers, stream);
-            case PacketId::C_FULL_GAME_REQUEST:
-                return handlePacket<FullGameRequestPacket>(handlers, stream);
-            case PacketId::C_POWER_UP:
-                return handlePacket<PowerUpPacket>(handlers, stream);
-            case PacketId::S_DISCONNECT:
-                return handlePacket<DisconnectPacket>(handlers, stream);
-            case PacketId::S_CONNECT:
-                return handlePacket<ConnectPacket>(handlers, stream);
-            default:
-                LogLevel::WARNING << "reveived packet with unknown id '" << id << "'" << std::endl;
+        // Packets come from the other side, a malformed one must not take
+        // the whole process down
+        try {
+            id << stream;
+            DecodeFunction decode = nullptr;
+            if (id < PACKET_DECODERS.size())
+                decode = PACKET_DECODERS[id];
+            else if (id - HANDSHAKE_IDS < HANDSHAKE_DECODERS.size())
+                decode = HANDSHAKE_DECODERS[id - HANDSHAKE_IDS];
+            if (decode == nullptr) {
+                LogLevel::WARNING << "received packet with unknown id '" << id << "'"
+                                  << std::endl;
                 return false;
+            }
+            return decode(handlers, stream);
+        } catch (const NetworkStreamOverflowException &) {
+            LogLevel::WARNING << "received malformed packet with id '" << id << "'" << std::endl;
         }
+        return false;
     }
 
     bool PacketHandler::handle(TestPacket &)
@@ -80,6 +139,11 @@ namespace tetriq {
         return false;
     }
 
+    bool PacketHandler::handle(GameInputPacket &)
+    {
+        return false;
+    }
+
     bool PacketHandler::handle(FullGameRequestPacket &)
     {
         return false;
@@ -99,4 +163,19 @@ namespace tetriq {
     {
         return false;
     }
+
+    bool PacketHandler::handle(DeltaGamePacket &)
+    {
+        return false;
+    }
+
+    bool PacketHandler::handle(ClientHelloPacket &)
+    {
+        return false;
+    }
+
+    bool PacketHandler::handle(ServerHelloPacket &)
+    {
+        return false;
+    }
 }
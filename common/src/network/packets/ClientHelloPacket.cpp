@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "network/packets/ClientHelloPacket.hpp"
+#include "network/PacketId.hpp"
+#include <cstdint>
+
+namespace tetriq {
+    ClientHelloPacket::ClientHelloPacket()
+        : _protocol_version(0)
+        , _wire_formats(0)
+        , _capabilities(0)
+    {}
+
+    ClientHelloPacket::ClientHelloPacket(
+        uint64_t protocol_version, uint64_t wire_formats, uint64_t capabilities)
+        : _protocol_version(protocol_version)
+        , _wire_formats(wire_formats)
+        , _capabilities(capabilities)
+    {}
+
+    PacketId ClientHelloPacket::getId() const
+    {
+        return ID;
+    }
+
+    uint64_t ClientHelloPacket::getProtocolVersion() const
+    {
+        return _protocol_version;
+    }
+
+    uint64_t ClientHelloPacket::getWireFormats() const
+    {
+        return _wire_formats;
+    }
+
+    uint64_t ClientHelloPacket::getCapabilities() const
+    {
+        return _capabilities;
+    }
+
+    NetworkOStream &ClientHelloPacket::operator>>(NetworkOStream &ns) const
+    {
+        _protocol_version >> ns;
+        _wire_formats >> ns;
+        _capabilities >> ns;
+        return ns;
+    }
+
+    NetworkIStream &ClientHelloPacket::operator<<(NetworkIStream &ns)
+    {
+        _protocol_version << ns;
+        _wire_formats << ns;
+        _capabilities << ns;
+        return ns;
+    }
+
+    size_t ClientHelloPacket::getNetworkSize(WireFormat format) const
+    {
+        return getWireSize(_protocol_version, format) + getWireSize(_wire_formats, format)
+            + getWireSize(_capabilities, format);
+    }
+}
@@ -16,7 +16,7 @@ namespace tetriq {
 
     PacketId ConnectPacket::getId() const
     {
-        return PacketId::S_CONNECT;
+        return ID;
     }
 
     uint64_t ConnectPacket::getGameWidth() const
@@ -50,8 +50,9 @@ namespace tetriq {
         return ns;
     }
 
-    size_t ConnectPacket::getNetworkSize() const
+    size_t ConnectPacket::getNetworkSize(WireFormat format) const
     {
-        return sizeof(_player_id) + sizeof(_game_width) + sizeof(_game_height);
+        return getWireSize(_player_id, format) + getWireSize(_game_width, format)
+            + getWireSize(_game_height, format);
     }
 }
@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "network/packets/DeltaGamePacket.hpp"
+#include "TetrisDelta.hpp"
+#include "network/PacketId.hpp"
+#include <cstdint>
+
+namespace tetriq {
+    DeltaGamePacket::DeltaGamePacket()
+    {}
+
+    DeltaGamePacket::DeltaGamePacket(
+        uint64_t player_id, const TetrisDelta &delta, uint64_t applied_actions)
+        : _player_id(player_id)
+        , _delta(delta)
+        , _applied_actions(applied_actions)
+    {}
+
+    PacketId DeltaGamePacket::getId() const
+    {
+        return ID;
+    }
+
+    uint64_t DeltaGamePacket::getPlayerId() const
+    {
+        return _player_id;
+    }
+
+    const TetrisDelta &DeltaGamePacket::getDelta() const
+    {
+        return _delta;
+    }
+
+    uint64_t DeltaGamePacket::getAppliedActions() const
+    {
+        return _applied_actions;
+    }
+
+    NetworkOStream &DeltaGamePacket::operator>>(NetworkOStream &ns) const
+    {
+        _player_id >> ns;
+        _delta >> ns;
+        _applied_actions >> ns;
+        return ns;
+    }
+
+    NetworkIStream &DeltaGamePacket::operator<<(NetworkIStream &ns)
+    {
+        _player_id << ns;
+        _delta << ns;
+        _applied_actions << ns;
+        return ns;
+    }
+
+    size_t DeltaGamePacket::getNetworkSize(WireFormat format) const
+    {
+        return getWireSize(_player_id, format) + getWireSize(_applied_actions, format)
+            + _delta.getNetworkSize(format);
+    }
+}
@@ -14,7 +14,7 @@ namespace tetriq {
 
     PacketId DisconnectPacket::getId() const
     {
-        return PacketId::S_DISCONNECT;
+        return ID;
     }
 
     uint64_t DisconnectPacket::getPlayerId() const
@@ -34,8 +34,8 @@ namespace tetriq {
         return ns;
     }
 
-    size_t DisconnectPacket::getNetworkSize() const
+    size_t DisconnectPacket::getNetworkSize(WireFormat format) const
     {
-        return sizeof(_player_id);
+        return getWireSize(_player_id, format);
     }
 }
@@ -19,7 +19,7 @@ namespace tetriq {
 
     PacketId FullGamePacket::getId() const
     {
-        return PacketId::S_FULL_GAME;
+        return ID;
     }
 
     uint64_t FullGamePacket::getPlayerId() const
@@ -53,8 +53,9 @@ namespace tetriq {
         return ns;
     }
 
-    size_t FullGamePacket::getNetworkSize() const
+    size_t FullGamePacket::getNetworkSize(WireFormat format) const
     {
-        return sizeof(_player_id) + sizeof(_applied_actions) + _game.getNetworkSize();
+        return getWireSize(_player_id, format) + getWireSize(_applied_actions, format)
+            + _game.getNetworkSize(format);
     }
 }
@@ -8,7 +8,7 @@
 namespace tetriq {
     PacketId FullGameRequestPacket::getId() const
     {
-        return PacketId::C_FULL_GAME_REQUEST;
+        return ID;
     }
 
     NetworkOStream &FullGameRequestPacket::operator>>(NetworkOStream &os) const
@@ -21,7 +21,7 @@ namespace tetriq {
         return os;
     }
 
-    size_t FullGameRequestPacket::getNetworkSize() const
+    size_t FullGameRequestPacket::getNetworkSize(WireFormat) const
     {
         return 0;
     }
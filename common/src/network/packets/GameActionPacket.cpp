@@ -16,7 +16,7 @@ namespace tetriq {
 
     PacketId GameActionPacket::getId() const
     {
-        return PacketId::C_GAME_ACTION;
+        return ID;
     }
 
     GameAction GameActionPacket::getAction() const
@@ -34,8 +34,8 @@ namespace tetriq {
         return _action << ns;
     }
 
-    size_t GameActionPacket::getNetworkSize() const
+    size_t GameActionPacket::getNetworkSize(WireFormat format) const
     {
-        return sizeof(GameAction);
+        return getWireSize(_action, format);
     }
 }
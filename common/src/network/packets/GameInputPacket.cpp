@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "network/packets/GameInputPacket.hpp"
+#include "GameAction.hpp"
+#include "network/PacketId.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace tetriq {
+    GameInputPacket::GameInputPacket()
+    {}
+
+    GameInputPacket::GameInputPacket(uint64_t sequence, const Actions &actions)
+        : _sequence(sequence)
+        , _actions(actions)
+    {}
+
+    PacketId GameInputPacket::getId() const
+    {
+        return ID;
+    }
+
+    uint64_t GameInputPacket::getSequence() const
+    {
+        return _sequence;
+    }
+
+    const GameInputPacket::Actions &GameInputPacket::getActions() const
+    {
+        return _actions;
+    }
+
+    NetworkOStream &GameInputPacket::operator>>(NetworkOStream &ns) const
+    {
+        _sequence >> ns;
+        _actions >> ns;
+        return ns;
+    }
+
+    NetworkIStream &GameInputPacket::operator<<(NetworkIStream &ns)
+    {
+        _sequence << ns;
+        _actions << ns;
+        return ns;
+    }
+
+    size_t GameInputPacket::getNetworkSize(WireFormat format) const
+    {
+        return getWireSize(_sequence, format) + getWireSize(_actions, format);
+    }
+}
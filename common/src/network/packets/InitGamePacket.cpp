@@ -10,20 +10,22 @@ namespace tetriq {
     InitGamePacket::InitGamePacket()
         : _game_width(0)
         , _game_height(0)
+        , _seed(0)
         , _player_ids()
     {}
 
     InitGamePacket::InitGamePacket(
-        uint64_t game_width, uint64_t game_height, uint64_t player_id, const std::vector<uint64_t> &player_ids)
+        uint64_t game_width, uint64_t game_height, uint64_t seed, uint64_t player_id, const std::vector<uint64_t> &player_ids)
         : _game_width(game_width)
         , _game_height(game_height)
+        , _seed(seed)
         , _player_id(player_id)
         , _player_ids(player_ids)
     {}
 
     PacketId InitGamePacket::getId() const
     {
-        return PacketId::S_INIT_GAME;
+        return ID;
     }
 
     uint64_t InitGamePacket::getGameWidth() const
@@ -36,6 +38,11 @@ namespace tetriq {
         return _game_height;
     }
 
+    uint64_t InitGamePacket::getSeed() const
+    {
+        return _seed;
+    }
+
     uint64_t InitGamePacket::getPlayerId() const
     {
         return _player_id;
@@ -50,6 +57,7 @@ namespace tetriq {
     {
         _game_width >> ns;
         _game_height >> ns;
+        ns.writeFixed64(_seed);
         _player_id >> ns;
         _player_ids >> ns;
         return ns;
@@ -59,13 +67,15 @@ namespace tetriq {
     {
         _game_width << ns;
         _game_height << ns;
+        _seed = ns.readFixed64();
         _player_id << ns;
         _player_ids << ns;
         return ns;
     }
 
-    size_t InitGamePacket::getNetworkSize() const
+    size_t InitGamePacket::getNetworkSize(WireFormat format) const
     {
-        return sizeof(uint64_t) * (4 + _player_ids.size());
+        return getWireSize(_game_width, format) + getWireSize(_game_height, format)
+            + sizeof(_seed) + getWireSize(_player_id, format) + getWireSize(_player_ids, format);
     }
 }
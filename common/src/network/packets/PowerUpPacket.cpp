@@ -12,7 +12,7 @@ tetriq::PowerUpPacket::PowerUpPacket(uint64_t target)
 
 tetriq::PacketId tetriq::PowerUpPacket::getId() const
 {
-    return PacketId::C_POWER_UP;
+    return ID;
 }
 
 tetriq::NetworkOStream &tetriq::PowerUpPacket::operator>>(NetworkOStream &ns) const
@@ -25,9 +25,9 @@ tetriq::NetworkIStream &tetriq::PowerUpPacket::operator<<(NetworkIStream &ns)
     return _target << ns;
 }
 
-size_t tetriq::PowerUpPacket::getNetworkSize() const
+size_t tetriq::PowerUpPacket::getNetworkSize(WireFormat format) const
 {
-    return sizeof(uint64_t);
+    return getWireSize(_target, format);
 }
 
 uint64_t tetriq::PowerUpPacket::getTarget() const
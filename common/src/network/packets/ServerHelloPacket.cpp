@@ -0,0 +1,69 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "network/packets/ServerHelloPacket.hpp"
+#include "network/PacketId.hpp"
+#include <cstdint>
+
+namespace tetriq {
+    ServerHelloPacket::ServerHelloPacket()
+        : _protocol_version(0)
+        , _wire_format(WireFormat::FIXED)
+        , _capabilities(0)
+    {}
+
+    ServerHelloPacket::ServerHelloPacket(
+        uint64_t protocol_version, WireFormat wire_format, uint64_t capabilities)
+        : _protocol_version(protocol_version)
+        , _wire_format(wire_format)
+        , _capabilities(capabilities)
+    {}
+
+    PacketId ServerHelloPacket::getId() const
+    {
+        return ID;
+    }
+
+    uint64_t ServerHelloPacket::getProtocolVersion() const
+    {
+        return _protocol_version;
+    }
+
+    WireFormat ServerHelloPacket::getWireFormat() const
+    {
+        return _wire_format;
+    }
+
+    uint64_t ServerHelloPacket::getCapabilities() const
+    {
+        return _capabilities;
+    }
+
+    NetworkOStream &ServerHelloPacket::operator>>(NetworkOStream &ns) const
+    {
+        _protocol_version >> ns;
+        static_cast<uint8_t>(_wire_format) >> ns;
+        _capabilities >> ns;
+        return ns;
+    }
+
+    NetworkIStream &ServerHelloPacket::operator<<(NetworkIStream &ns)
+    {
+        uint8_t wire_format;
+
+        _protocol_version << ns;
+        wire_format << ns;
+        _capabilities << ns;
+        if (!isWireFormat(wire_format))
+            throw NetworkStreamOverflowException();
+        _wire_format = static_cast<WireFormat>(wire_format);
+        return ns;
+    }
+
+    size_t ServerHelloPacket::getNetworkSize(WireFormat format) const
+    {
+        return getWireSize(_protocol_version, format) + sizeof(uint8_t)
+            + getWireSize(_capabilities, format);
+    }
+}
@@ -12,7 +12,7 @@ tetriq::TestPacket::TestPacket() = default;
 
 tetriq::PacketId tetriq::TestPacket::getId() const
 {
-    return PacketId::TEST;
+    return ID;
 }
 
 tetriq::NetworkOStream &tetriq::TestPacket::operator>>(tetriq::NetworkOStream &ns) const
@@ -32,7 +32,7 @@ tetriq::NetworkIStream &tetriq::TestPacket::operator<<(tetriq::NetworkIStream &n
     return ns;
 }
 
-size_t tetriq::TestPacket::getNetworkSize() const
+size_t tetriq::TestPacket::getNetworkSize(WireFormat format) const
 {
-    return sizeof(uint64_t);
+    return getWireSize(_magic, format);
 }
@@ -12,13 +12,16 @@ namespace tetriq {
     TickGamePacket::TickGamePacket()
     {}
 
-    TickGamePacket::TickGamePacket(uint64_t applied_actions)
+    TickGamePacket::TickGamePacket(
+        uint64_t applied_actions, uint64_t game_hash, uint64_t input_sequence)
         : _applied_actions(applied_actions)
+        , _game_hash(game_hash)
+        , _input_sequence(input_sequence)
     {}
 
     PacketId TickGamePacket::getId() const
     {
-        return PacketId::S_TICK_GAME;
+        return ID;
     }
 
     uint64_t TickGamePacket::getAppliedActions() const
@@ -26,20 +29,35 @@ namespace tetriq {
         return _applied_actions;
     }
 
+    uint64_t TickGamePacket::getGameHash() const
+    {
+        return _game_hash;
+    }
+
+    uint64_t TickGamePacket::getInputSequence() const
+    {
+        return _input_sequence;
+    }
+
     NetworkOStream &TickGamePacket::operator>>(NetworkOStream &ns) const
     {
         _applied_actions >> ns;
+        ns.writeFixed64(_game_hash);
+        _input_sequence >> ns;
         return ns;
     }
 
     NetworkIStream &TickGamePacket::operator<<(NetworkIStream &ns)
     {
         _applied_actions << ns;
+        _game_hash = ns.readFixed64();
+        _input_sequence << ns;
         return ns;
     }
 
-    size_t TickGamePacket::getNetworkSize() const
+    size_t TickGamePacket::getNetworkSize(WireFormat format) const
     {
-        return sizeof(_applied_actions);
+        return getWireSize(_applied_actions, format) + sizeof(_game_hash)
+            + getWireSize(_input_sequence, format);
     }
 }
@@ -0,0 +1,43 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+
+namespace tetriq {
+    /**
+     * What a packet about the board of a player is, which tells the network
+     * thread what it may drop while a peer is congested.
+     */
+    enum class BoardPacket : uint8_t {
+        // The player joining, never dropped
+        CONNECT,
+        // The player leaving, never dropped. The held updates become useless.
+        DISCONNECT,
+        // Only valid after the previous updates, dropped once superseded
+        DELTA,
+        // The whole board, dropped once superseded. The held updates become
+        // useless.
+        KEYFRAME,
+    };
+
+    /**
+     * @returns true if the packet makes the previous updates about the same
+     * player useless.
+     */
+    constexpr bool supersedesUpdates(BoardPacket kind)
+    {
+        return kind == BoardPacket::DISCONNECT || kind == BoardPacket::KEYFRAME;
+    }
+
+    /**
+     * @returns true if the packet is an update of the board, which a later
+     * one may supersede.
+     */
+    constexpr bool isBoardUpdate(BoardPacket kind)
+    {
+        return kind == BoardPacket::DELTA || kind == BoardPacket::KEYFRAME;
+    }
+}
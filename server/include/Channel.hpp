@@ -4,11 +4,17 @@
 
 #pragma once
 
+#include "BoardPacket.hpp"
+#include "GameConfig.hpp"
 #include "Player.hpp"
 #include "network/APacket.hpp"
+#include "network/TrafficClass.hpp"
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <ctime>
+#include <enet/enet.h>
+#include <optional>
 #include <vector>
 
 namespace tetriq {
@@ -16,7 +22,11 @@ namespace tetriq {
 
     class Channel {
         public:
-            Channel(Server *server, uint64_t channel_id);
+            /**
+             * @param shard of the server the channel's players are connected
+             * to.
+             */
+            Channel(Server *server, uint64_t channel_id, size_t shard);
 
             /**
              * @returns true if the game is started
@@ -26,33 +36,164 @@ namespace tetriq {
             /**
              * @returns false if the player is already in the channel
              */
-            [[nodiscard]] bool addPlayer(Player &player);
-            void removePlayer(Player &player);
-            const std::vector<uint64_t> &getPlayers() const;
+            [[nodiscard]] bool addPlayer(PlayerHandle player);
+            void removePlayer(PlayerHandle player);
+            const std::vector<PlayerHandle> &getPlayers() const;
 
             /**
-             * @brief Get a player by its id (call _server.getPlayerById(id))
+             * @brief Get a player of the channel by its network id
              * @param id of the player
              * @return the player with the given id if it exists and is in the channel
              * @throw std::out_of_range if the player is not in the channel
              */
             Player &getPlayerById(uint64_t id);
 
+            /**
+             * Starts a new game, the server must then schedule its ticks, see
+             * Server::startGame().
+             */
             void startGame();
             void stopGame();
+
+            /**
+             * Updates the channel's games. What must be sent is only recorded,
+             * and sent by sendRecords() after the next call to swapRecords().
+             *
+             * Channels only touch their own players here, so different
+             * channels can tick in parallel as long as no player or channel is
+             * added or removed meanwhile. A channel can also tick while its
+             * previous records are being sent.
+             */
             void tick();
 
-            void broadcastPacket(const APacket &packet);
+            /**
+             * Sends what the previous tick recorded.
+             */
+            void sendRecords();
+
+            /**
+             * Makes what the last tick recorded pending, called between ticks.
+             */
+            void swapRecords();
+
+            /**
+             * @returns the record buffer of the players waiting to be sent.
+             */
+            size_t getPendingRecord() const;
+
+            /**
+             * @returns when the pieces should fall next, while the game is
+             * started.
+             */
+            std::chrono::steady_clock::time_point getNextGravity() const;
+
+            /**
+             * Makes the pieces fall on the next tick, and speeds the game up.
+             * @returns when they should fall after that.
+             */
+            std::chrono::steady_clock::time_point scheduleGravity(
+                std::chrono::steady_clock::time_point now);
+
+            /**
+             * Sends a packet on the game channel to the players having all the
+             * required capabilities and none of the excluded ones. Players
+             * still waiting for their hello get no broadcast.
+             */
+            void broadcastPacket(
+                const APacket &packet, uint64_t required = 0, uint64_t excluded = 0);
+
+            /**
+             * Broadcasts an update about the board of a player on the board
+             * channel, which other players may get late or never when they are
+             * congested, see Player::sendBoard(). The player itself gets it on
+             * the game channel, in order with its ticks.
+             */
+            void broadcastBoard(const APacket &packet,
+                uint64_t player_id,
+                BoardPacket kind,
+                uint64_t required = 0,
+                uint64_t excluded = 0);
+
+            /**
+             * Like broadcastBoard() but unreliable for the other players, for
+             * updates which the next one replaces whole.
+             */
+            void broadcastSnapshot(const APacket &packet,
+                uint64_t player_id,
+                uint64_t required = 0,
+                uint64_t excluded = 0);
+
+            /**
+             * @returns true if every player in the channel has all the
+             * given capabilities.
+             */
+            bool allPlayersHave(uint64_t capabilities) const;
+
+            /**
+             * Queues a packet to be sent to a peer on the next flush, keeping
+             * a reference to it until then.
+             */
+            void queuePacket(ENetPeer *peer, ENetPacket *packet, enet_uint8 channel_id);
+
+            /**
+             * Queues an update about the board of a player, see
+             * NetworkThread::sendBoard().
+             */
+            void queueBoard(ENetPeer *peer,
+                ENetPacket *packet,
+                enet_uint8 channel_id,
+                uint64_t player_id,
+                BoardPacket kind);
+
+            /**
+             * Queues a disconnection, handed to the network in order with the
+             * queued packets.
+             */
+            void queueDisconnect(ENetPeer *peer);
+
+            /**
+             * Hands the queued packets to the network thread, in the order
+             * they were queued. Must be called from the main thread.
+             */
+            void flushPackets();
+
+            const GameConfig &getGameConfig() const;
 
             uint64_t getChannelId() const;
+            size_t getShard() const;
 
         private:
+            struct QueuedPacket {
+                    ENetPeer *peer;
+                    // nullptr for a disconnection
+                    ENetPacket *packet;
+                    enet_uint8 channel_id;
+                    // Player whose board the packet is about, if any
+                    std::optional<uint64_t> board;
+                    BoardPacket kind;
+            };
+
+            /**
+             * @param board player whose board the packet is about, if any.
+             */
+            void broadcast(const APacket &packet,
+                TrafficClass traffic_class,
+                std::optional<uint64_t> board,
+                BoardPacket kind,
+                uint64_t required,
+                uint64_t excluded);
+
             Server *_server;
-            std::chrono::steady_clock::duration _next_tick;
+            std::chrono::steady_clock::time_point _next_gravity;
+            bool _gravity_due{false};
+            // Record buffer filled by the ticks, see Player::recordChanges()
+            size_t _record_buffer{0};
             bool _game_started;
-            std::vector<uint64_t> _players;
+            std::vector<PlayerHandle> _players;
             uint64_t _channel_id;
+            size_t _shard;
             uint64_t _game_speed;
             uint64_t _base_game_speed;
+            std::vector<QueuedPacket> _outbox;
     };
 }
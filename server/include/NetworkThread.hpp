@@ -0,0 +1,209 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include "BoardPacket.hpp"
+#include "SpscQueue.hpp"
+#include "network/PacketDecoder.hpp"
+#include "network/packets/ClientHelloPacket.hpp"
+#include "network/packets/FullGameRequestPacket.hpp"
+#include "network/packets/GameActionPacket.hpp"
+#include "network/packets/GameInputPacket.hpp"
+#include "network/packets/PowerUpPacket.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <enet/enet.h>
+#include <thread>
+#include <vector>
+
+namespace tetriq {
+    /**
+     * The packets clients send to the server.
+     */
+    using ClientPacketDecoder = PacketDecoder<GameActionPacket,
+        GameInputPacket,
+        FullGameRequestPacket,
+        PowerUpPacket,
+        ClientHelloPacket>;
+
+    /**
+     * An event of an ENet host, with the received packet already decoded.
+     */
+    struct NetworkEvent {
+            ENetEventType type;
+            ENetPeer *peer;
+            enet_uint32 data;
+            // Only for ENET_EVENT_TYPE_RECEIVE
+            ClientPacketDecoder::Packet packet;
+    };
+
+    /**
+     * @brief Thread owning an ENet host. It services the host on its own so
+     * that bursts of network traffic don't delay the game's ticks, and
+     * exchanges events and packets with the server's main thread through
+     * lock-free queues.
+     *
+     * Every other method is meant to be called from a single thread, the
+     * one handling the events.
+     */
+    class NetworkThread {
+        public:
+            explicit NetworkThread(ENetHost *host);
+            ~NetworkThread();
+
+            NetworkThread(const NetworkThread &) = delete;
+            NetworkThread &operator=(const NetworkThread &) = delete;
+
+            /**
+             * @returns a file descriptor becoming readable when events are
+             * waiting, to be used with epoll or the likes.
+             */
+            int getEventFd() const;
+
+            /**
+             * Resets the event file descriptor, must be called before polling
+             * the events it signaled.
+             */
+            void acknowledgeEvents();
+
+            /**
+             * @returns false if there is no event waiting. Received packets
+             * are decoded by the network thread with the peer's wire format.
+             */
+            bool pollEvent(NetworkEvent &event);
+
+            /**
+             * Sets the wire format used to decode the next packets of a peer,
+             * which starts with WireFormat::FIXED for the handshake.
+             */
+            void setWireFormat(ENetPeer *peer, WireFormat format);
+
+            /**
+             * Sends a packet, taking over one of its references.
+             * @param channel_id see getChannelId().
+             */
+            void send(ENetPeer *peer, ENetPacket *packet, enet_uint8 channel_id);
+
+            /**
+             * Sends an update about another player's board, taking over one of
+             * its references. It is held back while the peer is congested or
+             * lagging, and board updates are dropped once superseded.
+             */
+            void sendBoard(ENetPeer *peer,
+                ENetPacket *packet,
+                enet_uint8 channel_id,
+                uint64_t player_id,
+                BoardPacket kind);
+
+            /**
+             * Disconnects a peer, see enet_peer_disconnect().
+             */
+            void disconnect(ENetPeer *peer);
+
+            /**
+             * Lets the peer be used again once its disconnect event was
+             * handled. Until then, what is sent to it is dropped, as ENet may
+             * already have given the peer to a new client.
+             */
+            void release(ENetPeer *peer);
+
+            /**
+             * Wakes the network thread up to run what was sent so far.
+             */
+            void flush();
+
+        private:
+            enum class CommandType : uint8_t {
+                SEND,
+                SEND_BOARD,
+                DISCONNECT,
+                RELEASE,
+                SET_WIRE_FORMAT,
+            };
+
+            struct Command {
+                    CommandType type;
+                    enet_uint8 channel_id;
+                    // Only for SEND_BOARD
+                    BoardPacket kind;
+                    // Only for SET_WIRE_FORMAT
+                    WireFormat wire_format;
+                    ENetPeer *peer;
+                    ENetPacket *packet;
+                    uint64_t player_id;
+            };
+
+            struct HeldBoard {
+                    uint64_t player_id;
+                    ENetPacket *packet;
+                    enet_uint8 channel_id;
+                    BoardPacket kind;
+            };
+
+            /**
+             * State of a peer, only used by the network thread.
+             */
+            struct PeerState {
+                    // Disconnect events not handled yet
+                    uint32_t pending_disconnects{0};
+                    // Board updates waiting for the peer to catch up, in order
+                    std::vector<HeldBoard> held_boards;
+                    // Board updates are held until then, see enet_time_get()
+                    enet_uint32 next_board_release{0};
+                    WireFormat wire_format{WireFormat::FIXED};
+            };
+
+            static constexpr size_t EVENT_QUEUE_SIZE = 4096;
+            static constexpr size_t COMMAND_QUEUE_SIZE = 16384;
+            // Longest wait in milliseconds between two services of the host,
+            // which ENet needs for its resends and pings
+            static constexpr int SERVICE_INTERVAL = 10;
+            // Round trip time in milliseconds above which a peer only gets
+            // board updates once per round trip
+            static constexpr enet_uint32 LAGGING_ROUND_TRIP = 250;
+
+            void loop();
+            void pushCommand(const Command &command);
+            void pushEvent(const NetworkEvent &event);
+            void runCommands();
+            void signal(int fd);
+
+            void holdBoard(size_t index, const Command &command);
+
+            /**
+             * Sends the board updates held for the peers which caught up.
+             */
+            void releaseBoards();
+
+            /**
+             * @returns false if the peer is still congested or lagging.
+             */
+            bool releaseBoards(size_t index, enet_uint32 now);
+            void dropBoards(size_t index);
+
+            /**
+             * @returns true if the peer has more reliable data in transit than
+             * it should, so other packets would wait in ENet's queue.
+             */
+            static bool isCongested(const ENetPeer &peer);
+            static void sendPacket(ENetPeer &peer, ENetPacket *packet, enet_uint8 channel_id);
+            static void releasePacket(ENetPacket *packet);
+
+            ENetHost *_host;
+            int _epoll_fd;
+            // Signaled by the network thread when it pushes events
+            int _event_fd;
+            // Signaled by the main thread when it pushes commands
+            int _command_fd;
+            std::vector<PeerState> _peers;
+            // Peers with held board updates
+            std::vector<size_t> _throttled_peers;
+            SpscQueue<NetworkEvent, EVENT_QUEUE_SIZE> _events;
+            SpscQueue<Command, COMMAND_QUEUE_SIZE> _commands;
+            std::atomic<bool> _stopping{false};
+            std::thread _thread;
+    };
+}
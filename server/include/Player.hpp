@@ -4,51 +4,171 @@
 
 #pragma once
 
+#include "BoardPacket.hpp"
 #include "GameConfig.hpp"
+#include "SlotMap.hpp"
 #include "Tetris.hpp"
 #include "network/APacket.hpp"
 #include "network/PacketHandler.hpp"
+#include "network/TrafficClass.hpp"
 #include "network/packets/FullGameRequestPacket.hpp"
 #include "network/packets/GameActionPacket.hpp"
 #include <enet/enet.h>
+#include <array>
+#include <cstddef>
 #include <cstdint>
 
 namespace tetriq {
     class Channel;
+    class Server;
+    using ChannelHandle = SlotHandle<Channel>;
 
     class Player : public PacketHandler {
         public:
-            Player(uint64_t network_id, ENetPeer *peer, Channel &channel);
-            ~Player();
+            /**
+             * The client starts with a ClientHelloPacket, its game is only
+             * sent once it is received.
+             * @param channel the player is in, it must be added to it by the
+             * caller.
+             */
+            Player(Server *server, uint64_t network_id, ENetPeer *peer, ChannelHandle channel);
 
             void startGame(const GameConfig &config);
-            void tickGame();
-            void applyPackets();
+
+            /**
+             * Records the game if it changed since the last tick, and then
+             * its tick, in one of the record buffers. Nothing is sent until
+             * sendRecord() is called with that buffer, so that encoding can
+             * run while the next tick is simulated.
+             */
+            void recordChanges(size_t buffer);
+            void tickGame(size_t buffer);
+
+            /**
+             * Sends what was recorded in a buffer, and clears it.
+             */
+            void sendRecord(size_t buffer);
+
+            /**
+             * Broadcasts the whole game to the channel, it becomes the
+             * baseline of the next deltas. The pending record is sent first.
+             */
+            void broadcastKeyframe();
+
+            /**
+             * Sends the game as it was last broadcast to a single player, so
+             * that it can apply the next deltas.
+             */
+            void sendBaseline(Player &recipient);
             bool isGameOver() const;
             void setGameOver(bool game_over);
             Tetris &getGame();
 
             uint64_t getNetworkId() const;
+            WireFormat getWireFormat() const;
 
+            /**
+             * @returns the capabilities agreed on during the handshake, see
+             * network/Protocol.hpp.
+             */
+            uint64_t getCapabilities() const;
+            bool isAwaitingHello() const;
+
+            /**
+             * Packets are queued on the player's channel and only sent when it
+             * is flushed, see Channel::flushPackets().
+             */
             void sendPacket(const APacket &packet);
 
+            /**
+             * Sends an already serialized packet, see APacket::createENetPacket().
+             * It must use the player's wire format and the given traffic class.
+             */
+            void sendPacket(ENetPacket *packet, TrafficClass traffic_class);
+
+            /**
+             * Sends an update about the board of another player, which may be
+             * held back while the client is congested, see
+             * NetworkThread::sendBoard().
+             */
+            void sendBoard(ENetPacket *packet,
+                TrafficClass traffic_class,
+                uint64_t player_id,
+                BoardPacket kind);
+
             bool handle(GameActionPacket &packet) override;
+            bool handle(GameInputPacket &packet) override;
             bool handle(FullGameRequestPacket &packet) override;
             bool doPuSwitchField(BlockType power_up, Player &target);
             bool handle(PowerUpPacket &packet) override;
+            bool handle(ClientHelloPacket &packet) override;
 
             Channel &getChannel();
+
+            /**
+             * Queues the disconnection of the client, the player must then be
+             * removed from its channel and the server.
+             */
             bool disconnect();
 
             void sendInitGamePacket(const GameConfig &config);
 
         private:
-            const uint64_t _network_id;
-            ENetPeer *const _peer;
+            Server *_server;
+            uint64_t _network_id;
+            ENetPeer *_peer;
+            WireFormat _wire_format{WireFormat::FIXED};
+            uint64_t _capabilities{0};
+            bool _awaiting_hello{true};
 
-            Channel &_channel;
+            ChannelHandle _channel;
             Tetris _game;
 
+            /**
+             * Maximum number of DeltaGamePackets broadcast between two
+             * FullGamePackets, so that viewers which missed the baseline
+             * eventually catch up.
+             */
+            static constexpr uint64_t KEYFRAME_INTERVAL = 16;
+
+            /**
+             * The game as it was last broadcast to the channel.
+             */
+            Tetris _baseline;
+            uint64_t _deltas_since_keyframe{0};
+
             uint64_t _applied_actions{0};
+
+            /**
+             * Sequence number of the last action received through
+             * GameInputPacket. It carries over from game to game, like the
+             * client's.
+             */
+            uint64_t _input_sequence{0};
+
+            /**
+             * What happened to the game during a tick.
+             */
+            struct GameRecord {
+                    bool changed{false};
+                    Tetris game{12, 22};
+                    uint64_t changed_actions{0};
+
+                    bool ticked{false};
+                    uint64_t tick_actions{0};
+                    uint64_t tick_hash{0};
+                    uint64_t tick_input_sequence{0};
+            };
+
+            /**
+             * One is filled by the tick while the other, filled by the
+             * previous tick, is being sent, see Channel::tick().
+             */
+            std::array<GameRecord, 2> _records;
+
+            void broadcastChanges(GameRecord &record);
+            void broadcastKeyframe(const Tetris &game, uint64_t applied_actions);
     };
+
+    using PlayerHandle = SlotHandle<Player>;
 }
@@ -5,16 +5,22 @@
 #pragma once
 
 #include "Channel.hpp"
+#include "NetworkThread.hpp"
 #include "Player.hpp"
 #include "ServerConfig.hpp"
+#include "SlotMap.hpp"
+#include "WorkerPool.hpp"
 #include "rcon/Rcon.hpp"
 
 #include <chrono>
 #include <csignal>
 #include <cstdint>
+#include <functional>
 #include <toml++/toml.hpp>
 #include <enet/enet.h>
-#include <unordered_map>
+#include <memory>
+#include <queue>
+#include <random>
 #include <vector>
 
 extern bool should_exit;
@@ -60,20 +66,52 @@ namespace tetriq {
             void listen();
 
             /**
-             * @returns a player based on his network id.
+             * @returns a connected player.
              */
-            Player &getPlayerById(uint64_t id);
+            Player &getPlayer(PlayerHandle player);
 
             /**
              * @returns the server's config.
              */
             const ServerConfig &getConfig() const;
 
-            std::vector<Channel> &getChannels();
+            SlotMap<Channel> &getChannels();
+
+            /**
+             * @returns the channel, or nullptr if it was deleted.
+             */
+            Channel *getChannel(ChannelHandle channel);
+
+            /**
+             * @returns the channel with the given id, the handle is stale if
+             * there is none.
+             */
+            ChannelHandle findChannel(uint64_t id);
+
+            /**
+             * @returns the thread running a shard's network while listening.
+             */
+            NetworkThread &getNetwork(size_t shard);
 
             bool createChannel();
+
+            /**
+             * Starts the game of a channel and schedules its ticks.
+             * @returns false if the channel was deleted.
+             */
+            bool startGame(ChannelHandle channel);
+
+            /**
+             * @returns false if the channel doesn't exist, is the default
+             * channel of a shard or still has players.
+             */
             bool deleteChannel(uint64_t id);
 
+            /**
+             * @returns a new seed for a game's random number generator.
+             */
+            uint64_t generateSeed();
+
         private:
             /**
              * @brief Initialize the server
@@ -88,11 +126,39 @@ namespace tetriq {
             bool setHost();
 
             /**
-             * @brief Create the server host
-             * @return true if the server host was successfully created, false otherwise
+             * @brief Create the server hosts, one per shard
+             * @return true if the server hosts were successfully created, false otherwise
              */
             bool createHost();
 
+            /**
+             * @brief Create a host listening on a port other hosts may share
+             * @return the host, or nullptr if it could not be created
+             */
+            ENetHost *createSharedHost() const;
+
+            /**
+             * Sources of the events waited for by listen().
+             */
+            enum EventSource : uint32_t {
+                TICK_EVENT,
+                RCON_EVENT,
+                // Followed by one source per shard
+                NETWORK_EVENT,
+            };
+
+            /**
+             * @brief Watch a file descriptor for reading in an epoll instance
+             * @returns false if epoll_ctl() failed.
+             */
+            static bool addEventSource(int epoll_fd, int fd, uint32_t source);
+
+            /**
+             * @brief Tick the channels with a started game, and make pieces
+             * fall in those where it is due.
+             */
+            void tickChannels();
+
             /**
              * @brief Handle all rcon events.
              */
@@ -106,38 +172,63 @@ namespace tetriq {
             /**
              * @brief Handle a new client connection
              * @param event ENet event containing the new client connection
+             * @param shard the client connected to
              * @return true if the new client was successfully handled, false otherwise
              */
-            bool handleNewClient(ENetEvent &event);
+            bool handleNewClient(NetworkEvent &event, size_t shard);
 
             /**
              * @brief Handle a client disconnection
              * @param event ENet event containing the client disconnection
+             * @param shard the client was connected to
              */
-            void handleClientDisconnect(ENetEvent &event);
+            void handleClientDisconnect(NetworkEvent &event, size_t shard);
 
             /**
              * @brief Handle a client packet
-             * @param event ENet event containing the client packet
+             * @param event Network event containing the decoded client packet
              */
-            void handleClientPacket(ENetEvent &event);
+            void handleClientPacket(NetworkEvent &event);
 
             /**
              * @brief Handle None event (timeout)
              * @param event ENet event containing the None event
              */
-            void handleNone(ENetEvent &event) const;
+            void handleNone(NetworkEvent &event) const;
 
             const ServerConfig _config;
             ENetAddress _address;
-            ENetHost *_server;
+            std::vector<ENetHost *> _hosts;
+            std::vector<std::unique_ptr<NetworkThread>> _networks;
 
-            std::chrono::steady_clock::time_point _next_tick;
             bool _running{true};
             uint64_t _network_id_counter{0};
-            std::unordered_map<uint64_t, Player> _players;
+            SlotMap<Player> _players;
             uint64_t _channel_id_counter{0};
-            std::vector<Channel> _channels;
+            SlotMap<Channel> _channels;
+            // Default channel of each shard
+            std::vector<ChannelHandle> _default_channels;
+
+            struct GravityDeadline {
+                    std::chrono::steady_clock::time_point deadline;
+                    ChannelHandle channel;
+
+                    bool operator>(const GravityDeadline &other) const
+                    {
+                        return deadline > other.deadline;
+                    }
+            };
+
+            // Channels with a started game, only those are ticked
+            std::vector<ChannelHandle> _active_channels;
+            // Channels which ticked last time, their records are sent
+            // during the next tick
+            std::vector<ChannelHandle> _recorded_channels;
+            // May hold deadlines of stopped games, skipped once due
+            std::priority_queue<GravityDeadline, std::vector<GravityDeadline>, std::greater<>>
+                _gravity_deadlines;
+            std::mt19937_64 _seed_generator{std::random_device{}()};
             Rcon _rcon;
+            WorkerPool _tick_pool;
     };
 }
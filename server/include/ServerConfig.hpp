@@ -22,6 +22,8 @@ namespace tetriq {
             std::string listen_address = "0.0.0.0";
             uint16_t listen_port = 31457;
             uint32_t ticks_per_second = 60;
+            uint32_t tick_threads = 1;
+            uint32_t shards = 1;
             GameConfig game;
             RconConfig rcon;
     };
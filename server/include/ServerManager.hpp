@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: AGPL-3.0-or-later
 
 #pragma once
+#include "SlotMap.hpp"
+
 #include <queue>
 #include <string>
 #include <vector>
@@ -10,6 +12,7 @@
 namespace tetriq {
     class Server;
     class Channel;
+    using ChannelHandle = SlotHandle<Channel>;
 
 #define ASSERTS_ARGS(args, res_queue) \
     if (args.empty()) { \
@@ -34,7 +37,12 @@ namespace tetriq {
             void _delete(_args, std::queue<std::string> &res_queue);
 
         private:
+            /**
+             * @returns the selected channel, or nullptr if there is none.
+             */
+            Channel *getSelectedChannel();
+
             Server &_server;
-            Channel *_selected_channel{nullptr};
+            ChannelHandle _selected_channel;
     };
 }
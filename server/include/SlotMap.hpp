@@ -0,0 +1,168 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace tetriq {
+    /**
+     * @brief Reference to a value in a SlotMap. It stays valid as long as the
+     * value exists, and becomes stale, never pointing to another value, once
+     * the value is erased.
+     */
+    template<typename T>
+    struct SlotHandle {
+            uint32_t index{0};
+            // Generation 0 is never used, so default handles are always stale
+            uint32_t generation{0};
+
+            bool operator==(const SlotHandle &other) const = default;
+
+            /**
+             * @returns the handle stored in a pointer, e.g. for ENetPeer::data.
+             */
+            void *toPointer() const
+            {
+                static_assert(sizeof(uintptr_t) >= sizeof(uint64_t));
+                return reinterpret_cast<void *>(
+                    static_cast<uintptr_t>(static_cast<uint64_t>(generation) << 32 | index));
+            }
+
+            static SlotHandle fromPointer(const void *pointer)
+            {
+                const uint64_t value = reinterpret_cast<uintptr_t>(pointer);
+                return {static_cast<uint32_t>(value), static_cast<uint32_t>(value >> 32)};
+            }
+    };
+
+    /**
+     * @brief Container giving out stable handles to its values while keeping
+     * them contiguous in memory. Erasing moves the last value in place of the
+     * erased one, so references to values are invalidated by any insertion
+     * or removal, and only handles should be kept.
+     */
+    template<typename T>
+    class SlotMap {
+        public:
+            using Handle = SlotHandle<T>;
+
+            template<typename... Args>
+            Handle emplace(Args &&...args)
+            {
+                uint32_t slot = _free_slot;
+                if (slot == NO_SLOT) {
+                    slot = static_cast<uint32_t>(_slots.size());
+                    _slots.push_back({1, 0});
+                } else {
+                    _free_slot = _slots[slot].index;
+                }
+                _values.emplace_back(std::forward<Args>(args)...);
+                _value_slots.push_back(slot);
+                _slots[slot].index = static_cast<uint32_t>(_values.size() - 1);
+                return {slot, _slots[slot].generation};
+            }
+
+            /**
+             * @returns false if the handle is stale.
+             */
+            bool erase(Handle handle)
+            {
+                if (get(handle) == nullptr)
+                    return false;
+                Slot &slot = _slots[handle.index];
+                const uint32_t index = slot.index;
+                if (index != _values.size() - 1) {
+                    _values[index] = std::move(_values.back());
+                    _value_slots[index] = _value_slots.back();
+                    _slots[_value_slots[index]].index = index;
+                }
+                _values.pop_back();
+                _value_slots.pop_back();
+                if (++slot.generation == 0)
+                    slot.generation = 1;
+                slot.index = _free_slot;
+                _free_slot = handle.index;
+                return true;
+            }
+
+            /**
+             * @returns the value, or nullptr if the handle is stale.
+             */
+            T *get(Handle handle)
+            {
+                if (handle.index >= _slots.size()
+                    || _slots[handle.index].generation != handle.generation)
+                    return nullptr;
+                return &_values[_slots[handle.index].index];
+            }
+
+            const T *get(Handle handle) const
+            {
+                return const_cast<SlotMap *>(this)->get(handle);
+            }
+
+            /**
+             * @returns the value of a handle known not to be stale.
+             */
+            T &operator[](Handle handle)
+            {
+                T *value = get(handle);
+                assert(value != nullptr);
+                return *value;
+            }
+
+            /**
+             * @returns the handle of the value at an index of values().
+             */
+            Handle getHandle(size_t index) const
+            {
+                const uint32_t slot = _value_slots[index];
+                return {slot, _slots[slot].generation};
+            }
+
+            /**
+             * @returns every value, in no particular order.
+             */
+            std::span<T> values()
+            {
+                return _values;
+            }
+
+            size_t size() const
+            {
+                return _values.size();
+            }
+
+            auto begin()
+            {
+                return _values.begin();
+            }
+
+            auto end()
+            {
+                return _values.end();
+            }
+
+        private:
+            static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+            struct Slot {
+                    uint32_t generation;
+                    // Index of the value if used, of the next free slot otherwise
+                    uint32_t index;
+            };
+
+            std::vector<T> _values;
+            // Slot of each value
+            std::vector<uint32_t> _value_slots;
+            std::vector<Slot> _slots;
+            uint32_t _free_slot{NO_SLOT};
+    };
+}
@@ -0,0 +1,56 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace tetriq {
+    /**
+     * @brief Fixed-capacity lock-free FIFO queue between exactly one
+     * producer thread and one consumer thread.
+     */
+    template<typename T, size_t N>
+    class SpscQueue {
+            static_assert((N & (N - 1)) == 0, "capacity must be a power of two");
+
+        public:
+            /**
+             * Only called by the producer.
+             * @returns false if the queue is full, in which case nothing is
+             * pushed.
+             */
+            bool push(const T &value)
+            {
+                const size_t tail = _tail.load(std::memory_order_relaxed);
+                if (tail - _head.load(std::memory_order_acquire) == N)
+                    return false;
+                _items[tail % N] = value;
+                _tail.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * Only called by the consumer.
+             * @returns false if the queue is empty.
+             */
+            bool pop(T &value)
+            {
+                const size_t head = _head.load(std::memory_order_relaxed);
+                if (head == _tail.load(std::memory_order_acquire))
+                    return false;
+                value = _items[head % N];
+                _head.store(head + 1, std::memory_order_release);
+                return true;
+            }
+
+        private:
+            std::array<T, N> _items{};
+            // On their own cache lines so the two threads don't fight over them
+            alignas(64) std::atomic<size_t> _head{0};
+            alignas(64) std::atomic<size_t> _tail{0};
+    };
+}
@@ -0,0 +1,70 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tetriq {
+    /**
+     * @brief Threads running batches of independent tasks. Each thread
+     * starts with its share of the batch and steals from the others once it
+     * is done, so uneven tasks still keep every thread busy.
+     */
+    class WorkerPool {
+        public:
+            /**
+             * @param threads number of threads running the tasks, the one
+             * calling run() included.
+             */
+            explicit WorkerPool(size_t threads);
+            ~WorkerPool();
+
+            WorkerPool(const WorkerPool &) = delete;
+            WorkerPool &operator=(const WorkerPool &) = delete;
+
+            /**
+             * Calls task(i) for every i in [0, count) and returns once they
+             * are all done. Tasks may run in parallel, in any order.
+             */
+            void run(size_t count, const std::function<void(size_t)> &task);
+
+        private:
+            /**
+             * Tasks [begin, end) of a thread. The thread takes them from the
+             * front and others steal them from the back.
+             */
+            struct TaskRange {
+                    std::mutex mutex;
+                    size_t begin{0};
+                    size_t end{0};
+            };
+
+            void workerLoop(size_t index);
+
+            /**
+             * Runs tasks until there are none left in any range.
+             */
+            void work(size_t index);
+            bool popTask(size_t index, size_t &task);
+            bool stealTask(size_t index, size_t &task);
+
+            std::vector<TaskRange> _ranges;
+            std::vector<std::thread> _threads;
+
+            std::mutex _mutex;
+            std::condition_variable _start_cv;
+            std::condition_variable _done_cv;
+            uint64_t _generation{0};
+            size_t _remaining{0};
+            bool _stopping{false};
+            const std::function<void(size_t)> *_task{nullptr};
+    };
+}
@@ -42,6 +42,12 @@ namespace tetriq {
             void listen();
             bool init();
 
+            /**
+             * @returns an epoll file descriptor becoming readable when a rcon
+             * socket is, or -1 if rcon isn't running.
+             */
+            int getPollFd() const;
+
             void registerCommand(const std::string &commandName,
                 void (ServerManager::*func)(
                     const std::vector<std::string> &, std::queue<std::string> &));
@@ -51,6 +57,7 @@ namespace tetriq {
             Server &_server;
             RconConfig _config;
             int _rcon_socket;
+            int _epoll_fd{-1};
             int _rcon_port;
             sockaddr_in _rcon_address;
 
@@ -4,20 +4,26 @@
 
 #include "Channel.hpp"
 #include "Logger.hpp"
+#include "NetworkThread.hpp"
 #include "Player.hpp"
 #include "Server.hpp"
 #include "network/APacket.hpp"
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <stdexcept>
 
 namespace tetriq {
-    Channel::Channel(Server *server, uint64_t channel_id)
+    Channel::Channel(Server *server, uint64_t channel_id, size_t shard)
         : _server(server)
-        , _next_tick()
+        , _next_gravity()
         , _game_started(false)
         , _players()
         , _channel_id(channel_id)
+        , _shard(shard)
     {}
 
     bool Channel::hasGameStarted() const
@@ -25,23 +31,18 @@ namespace tetriq {
         return _game_started;
     }
 
-    bool Channel::addPlayer(Player &player)
+    bool Channel::addPlayer(PlayerHandle player)
     {
-        uint64_t player_id = player.getNetworkId();
-        for (uint64_t id : _players) {
-            if (player_id == id) {
-                return false;
-            }
-        }
-        _players.emplace_back(player.getNetworkId());
+        if (std::find(_players.begin(), _players.end(), player) != _players.end())
+            return false;
+        _players.emplace_back(player);
         return true;
     }
 
-    void Channel::removePlayer(Player &player)
+    void Channel::removePlayer(PlayerHandle player)
     {
-        uint64_t player_id = player.getNetworkId();
         for (size_t i = 0; i < _players.size(); i++) {
-            if (player_id == _players[i]) {
+            if (player == _players[i]) {
                 _players[i] = _players.back();
                 _players.pop_back();
                 return;
@@ -49,32 +50,43 @@ namespace tetriq {
         }
     }
 
-    const std::vector<uint64_t> &Channel::getPlayers() const
+    const std::vector<PlayerHandle> &Channel::getPlayers() const
     {
         return _players;
     }
 
     Player &Channel::getPlayerById(uint64_t id)
     {
-        auto it = std::find(_players.begin(), _players.end(), id);
-        if (it == _players.end()) {
-            throw std::out_of_range("Player not found");
+        for (PlayerHandle handle : _players) {
+            Player &player = _server->getPlayer(handle);
+            if (player.getNetworkId() == id)
+                return player;
         }
-        return _server->getPlayerById(id);
+        throw std::out_of_range("Player not found");
     }
 
     void Channel::startGame()
     {
         LogLevel::DEBUG << "starting game" << std::endl;
-        for (uint64_t id : _players) {
-            Player &player = _server->getPlayerById(id);
+        // Still about the previous game
+        sendRecords();
+        for (PlayerHandle handle : _players) {
+            Player &player = _server->getPlayer(handle);
             Tetris &game = player.getGame();
-            game = Tetris(_server->getConfig().game.width, _server->getConfig().game.height);
+            game = Tetris(_server->getConfig().game.width,
+                _server->getConfig().game.height,
+                _server->generateSeed());
             player.startGame(_server->getConfig().game);
         }
+        // Only once every client has its new boards, so none misses a baseline
+        for (PlayerHandle handle : _players) {
+            _server->getPlayer(handle).broadcastKeyframe();
+        }
         _game_started = true;
         _game_speed = 333'333'333;
         _base_game_speed = _game_speed;
+        _next_gravity = std::chrono::steady_clock::now();
+        _gravity_due = false;
     }
 
     void Channel::stopGame()
@@ -94,24 +106,19 @@ namespace tetriq {
             return;
         }
 
-        for (uint64_t id : _players) {
-            Player &player = _server->getPlayerById(id);
-            player.applyPackets();
+        for (PlayerHandle handle : _players) {
+            Player &player = _server->getPlayer(handle);
+            player.recordChanges(_record_buffer);
         }
 
-        std::chrono::steady_clock::duration now =
-            std::chrono::steady_clock::now().time_since_epoch();
-        if (now < _next_tick)
+        if (!_gravity_due)
             return;
-        _next_tick = now + std::chrono::nanoseconds(_game_speed);
-        const uint64_t max_game_speed = _base_game_speed / 2;
-        if (_game_speed > max_game_speed)
-            _game_speed -= 100000;
+        _gravity_due = false;
 
         bool game_over = true;
-        for (uint64_t id : _players) {
-            Player &player = _server->getPlayerById(id);
-            player.tickGame();
+        for (PlayerHandle handle : _players) {
+            Player &player = _server->getPlayer(handle);
+            player.tickGame(_record_buffer);
             game_over &= player.isGameOver();
         }
 
@@ -119,15 +126,157 @@ namespace tetriq {
             stopGame();
     }
 
-    void Channel::broadcastPacket(const APacket &packet)
+    void Channel::sendRecords()
+    {
+        const size_t buffer = getPendingRecord();
+        for (PlayerHandle handle : _players) {
+            _server->getPlayer(handle).sendRecord(buffer);
+        }
+    }
+
+    void Channel::swapRecords()
+    {
+        _record_buffer ^= 1;
+    }
+
+    size_t Channel::getPendingRecord() const
+    {
+        return _record_buffer ^ 1;
+    }
+
+    std::chrono::steady_clock::time_point Channel::getNextGravity() const
+    {
+        return _next_gravity;
+    }
+
+    std::chrono::steady_clock::time_point Channel::scheduleGravity(
+        std::chrono::steady_clock::time_point now)
+    {
+        _gravity_due = true;
+        _next_gravity = now + std::chrono::nanoseconds(_game_speed);
+        const uint64_t max_game_speed = _base_game_speed / 2;
+        if (_game_speed > max_game_speed)
+            _game_speed -= 100000;
+        return _next_gravity;
+    }
+
+    void Channel::broadcastPacket(const APacket &packet, uint64_t required, uint64_t excluded)
+    {
+        broadcast(packet, TrafficClass::GAME, std::nullopt, {}, required, excluded);
+    }
+
+    void Channel::broadcastBoard(const APacket &packet,
+        uint64_t player_id,
+        BoardPacket kind,
+        uint64_t required,
+        uint64_t excluded)
+    {
+        broadcast(packet, TrafficClass::BOARD, player_id, kind, required, excluded);
+    }
+
+    void Channel::broadcastSnapshot(
+        const APacket &packet, uint64_t player_id, uint64_t required, uint64_t excluded)
+    {
+        broadcast(
+            packet, TrafficClass::SNAPSHOT, player_id, BoardPacket::KEYFRAME, required, excluded);
+    }
+
+    void Channel::broadcast(const APacket &packet,
+        TrafficClass traffic_class,
+        std::optional<uint64_t> board,
+        BoardPacket kind,
+        uint64_t required,
+        uint64_t excluded)
+    {
+        // Serialized once per wire format and reliability, and every peer
+        // using it gets a reference to the same packet
+        std::array<std::array<ENetPacket *, 2>, LATEST_WIRE_FORMAT> epackets{};
+        for (PlayerHandle handle : _players) {
+            Player &player = _server->getPlayer(handle);
+            // Its wire format isn't known yet, and the InitGamePacket will
+            // tell it about the others
+            if (player.isAwaitingHello())
+                continue;
+            const uint64_t capabilities = player.getCapabilities();
+            if ((capabilities & required) != required || (capabilities & excluded) != 0)
+                continue;
+            // The owner of a board counts its actions with it, so it must
+            // arrive in order with the ticks
+            const bool own_board = board == player.getNetworkId();
+            const TrafficClass player_class = own_board ? TrafficClass::GAME : traffic_class;
+            const WireFormat format = player.getWireFormat();
+            ENetPacket *&epacket = epackets[static_cast<uint8_t>(format) - 1]
+                                           [player_class == TrafficClass::SNAPSHOT];
+            if (epacket == nullptr)
+                epacket = packet.createENetPacket(format, player_class);
+            if (board && !own_board)
+                player.sendBoard(epacket, player_class, *board, kind);
+            else
+                player.sendPacket(epacket, player_class);
+        }
+    }
+
+    bool Channel::allPlayersHave(uint64_t capabilities) const
+    {
+        for (PlayerHandle handle : _players) {
+            if ((_server->getPlayer(handle).getCapabilities() & capabilities) != capabilities)
+                return false;
+        }
+        return true;
+    }
+
+    void Channel::queuePacket(ENetPeer *peer, ENetPacket *packet, enet_uint8 channel_id)
     {
-        for (uint64_t id : _players) {
-            _server->getPlayerById(id).sendPacket(packet);
+        packet->referenceCount++;
+        _outbox.push_back({peer, packet, channel_id, std::nullopt, {}});
+    }
+
+    void Channel::queueBoard(ENetPeer *peer,
+        ENetPacket *packet,
+        enet_uint8 channel_id,
+        uint64_t player_id,
+        BoardPacket kind)
+    {
+        packet->referenceCount++;
+        _outbox.push_back({peer, packet, channel_id, player_id, kind});
+    }
+
+    void Channel::queueDisconnect(ENetPeer *peer)
+    {
+        _outbox.push_back({peer, nullptr, 0, std::nullopt, {}});
+    }
+
+    void Channel::flushPackets()
+    {
+        NetworkThread &network = _server->getNetwork(_shard);
+        for (const QueuedPacket &queued : _outbox) {
+            // The network thread takes over the reference held by the outbox
+            if (queued.packet == nullptr)
+                network.disconnect(queued.peer);
+            else if (queued.board)
+                network.sendBoard(queued.peer,
+                    queued.packet,
+                    queued.channel_id,
+                    *queued.board,
+                    queued.kind);
+            else
+                network.send(queued.peer, queued.packet, queued.channel_id);
         }
+        _outbox.clear();
+    }
+
+    const GameConfig &Channel::getGameConfig() const
+    {
+        return _server->getConfig().game;
     }
 
     uint64_t Channel::getChannelId() const
     {
         return _channel_id;
     }
+
+    size_t Channel::getShard() const
+    {
+        return _shard;
+    }
 }
@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: AGPL-3.0-or-later
 
 #include "GameConfig.hpp"
+#include "Block.hpp"
+#include "Logger.hpp"
 
 namespace tetriq {
     GameConfig::GameConfig(toml::table &config)
@@ -11,5 +13,10 @@ namespace tetriq {
             config["ticks_per_second"].value<int64_t>().value_or(this->ticks_per_second);
         width = config["width"].value<int64_t>().value_or(this->width);
         height = config["height"].value<int64_t>().value_or(this->height);
+        if (width > MAX_BOARD_WIDTH) {
+            LogLevel::WARNING << "game width " << width << " is too large, using "
+                              << MAX_BOARD_WIDTH << " instead" << std::endl;
+            width = MAX_BOARD_WIDTH;
+        }
     }
 }
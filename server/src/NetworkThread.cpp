@@ -0,0 +1,287 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "NetworkThread.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+namespace tetriq {
+    NetworkThread::NetworkThread(ENetHost *host)
+        : _host(host)
+        , _epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+        , _event_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+        , _command_fd(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK))
+        , _peers(host->peerCount)
+    {
+        epoll_event socket_event{EPOLLIN, {.fd = _host->socket}};
+        epoll_event command_event{EPOLLIN, {.fd = _command_fd}};
+        if (_epoll_fd < 0 || _event_fd < 0 || _command_fd < 0
+            || epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _host->socket, &socket_event) != 0
+            || epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _command_fd, &command_event) != 0) {
+            const int error = errno;
+            close(_epoll_fd);
+            close(_event_fd);
+            close(_command_fd);
+            throw std::system_error(error, std::generic_category(), "network thread");
+        }
+        _thread = std::thread(&NetworkThread::loop, this);
+    }
+
+    NetworkThread::~NetworkThread()
+    {
+        _stopping.store(true, std::memory_order_relaxed);
+        signal(_command_fd);
+        _thread.join();
+        runCommands();
+        while (!_throttled_peers.empty()) {
+            dropBoards(_throttled_peers.back());
+        }
+        close(_epoll_fd);
+        close(_event_fd);
+        close(_command_fd);
+    }
+
+    int NetworkThread::getEventFd() const
+    {
+        return _event_fd;
+    }
+
+    void NetworkThread::acknowledgeEvents()
+    {
+        uint64_t count;
+        [[maybe_unused]] ssize_t result = read(_event_fd, &count, sizeof(count));
+    }
+
+    bool NetworkThread::pollEvent(NetworkEvent &event)
+    {
+        return _events.pop(event);
+    }
+
+    void NetworkThread::setWireFormat(ENetPeer *peer, WireFormat format)
+    {
+        pushCommand({CommandType::SET_WIRE_FORMAT, 0, {}, format, peer, nullptr, 0});
+    }
+
+    void NetworkThread::send(ENetPeer *peer, ENetPacket *packet, enet_uint8 channel_id)
+    {
+        pushCommand({CommandType::SEND, channel_id, {}, {}, peer, packet, 0});
+    }
+
+    void NetworkThread::sendBoard(ENetPeer *peer,
+        ENetPacket *packet,
+        enet_uint8 channel_id,
+        uint64_t player_id,
+        BoardPacket kind)
+    {
+        pushCommand({CommandType::SEND_BOARD, channel_id, kind, {}, peer, packet, player_id});
+    }
+
+    void NetworkThread::disconnect(ENetPeer *peer)
+    {
+        pushCommand({CommandType::DISCONNECT, 0, {}, {}, peer, nullptr, 0});
+    }
+
+    void NetworkThread::release(ENetPeer *peer)
+    {
+        pushCommand({CommandType::RELEASE, 0, {}, {}, peer, nullptr, 0});
+    }
+
+    void NetworkThread::flush()
+    {
+        signal(_command_fd);
+    }
+
+    void NetworkThread::signal(int fd)
+    {
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t result = write(fd, &one, sizeof(one));
+    }
+
+    void NetworkThread::pushCommand(const Command &command)
+    {
+        // The network thread never waits on us, so the queue can only stay
+        // full for a short while
+        while (!_commands.push(command)) {
+            signal(_command_fd);
+            std::this_thread::yield();
+        }
+    }
+
+    void NetworkThread::pushEvent(const NetworkEvent &event)
+    {
+        // Keep sending while the main thread catches up, it may be waiting
+        // for room in the command queue
+        while (!_events.push(event)) {
+            signal(_event_fd);
+            runCommands();
+            std::this_thread::yield();
+        }
+    }
+
+    void NetworkThread::runCommands()
+    {
+        Command command;
+        while (_commands.pop(command)) {
+            const size_t index = command.peer - _host->peers;
+            PeerState &peer = _peers[index];
+            switch (command.type) {
+                case CommandType::SEND:
+                    if (peer.pending_disconnects == 0)
+                        sendPacket(*command.peer, command.packet, command.channel_id);
+                    releasePacket(command.packet);
+                    break;
+                case CommandType::SEND_BOARD:
+                    if (peer.pending_disconnects != 0) {
+                        releasePacket(command.packet);
+                    } else if (!peer.held_boards.empty() || isCongested(*command.peer)
+                               || ENET_TIME_LESS(enet_time_get(), peer.next_board_release)) {
+                        holdBoard(index, command);
+                    } else {
+                        sendPacket(*command.peer, command.packet, command.channel_id);
+                        releasePacket(command.packet);
+                    }
+                    break;
+                case CommandType::DISCONNECT:
+                    if (peer.pending_disconnects == 0)
+                        enet_peer_disconnect(command.peer, 0);
+                    break;
+                case CommandType::RELEASE:
+                    peer.pending_disconnects--;
+                    break;
+                case CommandType::SET_WIRE_FORMAT:
+                    // Else meant for a previous client of the peer
+                    if (peer.pending_disconnects == 0)
+                        peer.wire_format = command.wire_format;
+                    break;
+            }
+        }
+    }
+
+    void NetworkThread::holdBoard(size_t index, const Command &command)
+    {
+        std::vector<HeldBoard> &held_boards = _peers[index].held_boards;
+        if (held_boards.empty())
+            _throttled_peers.push_back(index);
+        if (supersedesUpdates(command.kind)) {
+            // Connections and disconnections are always delivered
+            std::erase_if(held_boards, [&](const HeldBoard &board) {
+                if (board.player_id != command.player_id || !isBoardUpdate(board.kind))
+                    return false;
+                releasePacket(board.packet);
+                return true;
+            });
+        }
+        held_boards.push_back(
+            {command.player_id, command.packet, command.channel_id, command.kind});
+    }
+
+    void NetworkThread::releaseBoards()
+    {
+        const enet_uint32 now = enet_time_get();
+        for (size_t i = 0; i < _throttled_peers.size();) {
+            if (releaseBoards(_throttled_peers[i], now)) {
+                _throttled_peers[i] = _throttled_peers.back();
+                _throttled_peers.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    bool NetworkThread::releaseBoards(size_t index, enet_uint32 now)
+    {
+        ENetPeer &peer = _host->peers[index];
+        PeerState &state = _peers[index];
+        if (isCongested(peer) || ENET_TIME_LESS(now, state.next_board_release))
+            return false;
+        for (const HeldBoard &board : state.held_boards) {
+            sendPacket(peer, board.packet, board.channel_id);
+            releasePacket(board.packet);
+        }
+        state.held_boards.clear();
+        if (peer.roundTripTime > LAGGING_ROUND_TRIP)
+            state.next_board_release = now + peer.roundTripTime;
+        return true;
+    }
+
+    void NetworkThread::dropBoards(size_t index)
+    {
+        for (const HeldBoard &board : _peers[index].held_boards) {
+            releasePacket(board.packet);
+        }
+        _peers[index].held_boards.clear();
+        std::erase(_throttled_peers, index);
+    }
+
+    bool NetworkThread::isCongested(const ENetPeer &peer)
+    {
+        // Half of the window ENet allows, so that there is always room left
+        // for the packets about the player itself
+        const enet_uint32 window =
+            peer.packetThrottle * peer.windowSize / ENET_PEER_PACKET_THROTTLE_SCALE;
+        return peer.reliableDataInTransit >= window / 2;
+    }
+
+    void NetworkThread::sendPacket(ENetPeer &peer, ENetPacket *packet, enet_uint8 channel_id)
+    {
+        enet_peer_send(&peer, channel_id, packet);
+    }
+
+    void NetworkThread::releasePacket(ENetPacket *packet)
+    {
+        if (--packet->referenceCount == 0)
+            enet_packet_destroy(packet);
+    }
+
+    void NetworkThread::loop()
+    {
+        while (!_stopping.load(std::memory_order_relaxed)) {
+            uint64_t count;
+            [[maybe_unused]] ssize_t result = read(_command_fd, &count, sizeof(count));
+            runCommands();
+            releaseBoards();
+            bool pushed = false;
+            ENetEvent event;
+            while (enet_host_service(_host, &event, 0) > 0) {
+                const size_t index = event.peer - _host->peers;
+                NetworkEvent decoded{event.type, event.peer, event.data, {}};
+                switch (event.type) {
+                    case ENET_EVENT_TYPE_CONNECT:
+                        // The peer may have been used by another client
+                        _peers[index].wire_format = WireFormat::FIXED;
+                        break;
+                    case ENET_EVENT_TYPE_DISCONNECT:
+                        _peers[index].pending_disconnects++;
+                        dropBoards(index);
+                        break;
+                    case ENET_EVENT_TYPE_RECEIVE:
+                        // Decoding here keeps it off the main thread, which
+                        // only gets typed packets
+                        ClientPacketDecoder::decode(
+                            event.packet, _peers[index].wire_format, decoded.packet);
+                        break;
+                    case ENET_EVENT_TYPE_NONE:
+                        break;
+                }
+                pushEvent(decoded);
+                pushed = true;
+            }
+            if (pushed)
+                signal(_event_fd);
+            // Woken up by incoming datagrams and commands, the timeout only
+            // keeps ENet's timers running
+            epoll_event events[2];
+            epoll_wait(_epoll_fd, events, 2, SERVICE_INTERVAL);
+        }
+        enet_host_flush(_host);
+    }
+}
@@ -6,55 +6,132 @@
 #include "Channel.hpp"
 #include "GameConfig.hpp"
 #include "Logger.hpp"
+#include "Server.hpp"
+#include "TetrisDelta.hpp"
+#include "network/Protocol.hpp"
+#include "network/packets/DeltaGamePacket.hpp"
 #include "network/packets/FullGamePacket.hpp"
 #include "network/packets/FullGameRequestPacket.hpp"
 #include "network/packets/GameActionPacket.hpp"
+#include "network/packets/GameInputPacket.hpp"
 #include "network/packets/InitGamePacket.hpp"
+#include "network/packets/ServerHelloPacket.hpp"
 #include "network/packets/TickGamePacket.hpp"
-#include <cassert>
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
 #include <string>
+#include <utility>
 
 namespace tetriq {
-    Player::Player(uint64_t network_id, ENetPeer *peer, Channel &channel)
-        : _network_id(network_id)
+    Player::Player(Server *server, uint64_t network_id, ENetPeer *peer, ChannelHandle channel)
+        : _server(server)
+        , _network_id(network_id)
         , _peer(peer)
         , _channel(channel)
         , _game(12, 22)
+        , _baseline(12, 22)
     {
         Logger::log(LogLevel::INFO, "player " + std::to_string(_network_id) + " connected.");
-        // Network ids are unique so no way the player was already added
-        assert(channel.addPlayer(*this));
-    }
-
-    Player::~Player()
-    {
-        _channel.removePlayer(*this);
-        Logger::log(LogLevel::INFO, "player " + std::to_string(_network_id) + " disconnected.");
     }
 
     void Player::startGame(const GameConfig &config)
     {
+        // Without a handshake we don't know how to talk to the client yet,
+        // it will join the next game
+        if (_awaiting_hello) {
+            _game.setGameOver(true);
+            return;
+        }
         sendInitGamePacket(config);
-        FullGamePacket{_network_id, _game, 0}.send(_peer);
     }
 
-    void Player::tickGame()
+    void Player::tickGame(size_t buffer)
     {
         if (_game.isOver()) {
             return;
         }
         _game.tick();
-        TickGamePacket{_applied_actions}.send(_peer);
+        GameRecord &record = _records[buffer];
+        record.ticked = true;
+        record.tick_actions = _applied_actions;
+        record.tick_hash = _game.getHash();
+        record.tick_input_sequence = _input_sequence;
+        _applied_actions = 0;
+    }
+
+    void Player::recordChanges(size_t buffer)
+    {
+        if (!_game.isChanged())
+            return;
+        GameRecord &record = _records[buffer];
+        record.changed = true;
+        record.game = _game;
+        record.changed_actions = _applied_actions;
         _applied_actions = 0;
     }
 
-    void Player::applyPackets()
+    void Player::sendRecord(size_t buffer)
+    {
+        GameRecord &record = _records[buffer];
+        if (record.changed)
+            broadcastChanges(record);
+        if (record.ticked)
+            sendPacket(
+                TickGamePacket{record.tick_actions, record.tick_hash, record.tick_input_sequence});
+        record.changed = false;
+        record.ticked = false;
+    }
+
+    void Player::broadcastChanges(GameRecord &record)
     {
-        if (_game.isChanged()) {
-            _channel.broadcastPacket(FullGamePacket{_network_id, _game, _applied_actions});
-            _applied_actions = 0;
+        const Tetris &game = record.game;
+        if (_deltas_since_keyframe >= KEYFRAME_INTERVAL
+            || _baseline.getWidth() != game.getWidth()
+            || _baseline.getHeight() != game.getHeight()) {
+            broadcastKeyframe(game, record.changed_actions);
+            return;
         }
+        DeltaGamePacket packet{_network_id, TetrisDelta{_baseline, game}, record.changed_actions};
+        // Compared with varints, which most clients use
+        if (packet.getNetworkSize(WireFormat::VARINT) >= game.getNetworkSize(WireFormat::VARINT)) {
+            broadcastKeyframe(game, record.changed_actions);
+            return;
+        }
+        Channel &channel = getChannel();
+        channel.broadcastBoard(packet, _network_id, BoardPacket::DELTA, CAPABILITY_DELTA_GAME);
+        if (!channel.allPlayersHave(CAPABILITY_DELTA_GAME))
+            // Every update is whole for them, so a lost one doesn't matter
+            channel.broadcastSnapshot(FullGamePacket{_network_id, game, record.changed_actions},
+                _network_id,
+                0,
+                CAPABILITY_DELTA_GAME);
+        // The record's game is overwritten before being used again
+        std::swap(_baseline, record.game);
+        _deltas_since_keyframe++;
+    }
+
+    void Player::broadcastKeyframe()
+    {
+        sendRecord(getChannel().getPendingRecord());
+        broadcastKeyframe(_game, _applied_actions);
+        _applied_actions = 0;
+    }
+
+    void Player::sendBaseline(Player &recipient)
+    {
+        // The actions up to the baseline were counted in the previous
+        // broadcasts, the next delta counts the ones after it
+        recipient.sendPacket(FullGamePacket{_network_id, _baseline, 0});
+    }
+
+    void Player::broadcastKeyframe(const Tetris &game, uint64_t applied_actions)
+    {
+        getChannel().broadcastBoard(FullGamePacket{_network_id, game, applied_actions},
+            _network_id,
+            BoardPacket::KEYFRAME);
+        _baseline = game;
+        _deltas_since_keyframe = 0;
     }
 
     uint64_t Player::getNetworkId() const
@@ -62,9 +139,35 @@ namespace tetriq {
         return _network_id;
     }
 
+    WireFormat Player::getWireFormat() const
+    {
+        return _wire_format;
+    }
+
+    uint64_t Player::getCapabilities() const
+    {
+        return _capabilities;
+    }
+
+    bool Player::isAwaitingHello() const
+    {
+        return _awaiting_hello;
+    }
+
     void Player::sendPacket(const APacket &packet)
     {
-        packet.send(_peer);
+        sendPacket(packet.createENetPacket(_wire_format), TrafficClass::GAME);
+    }
+
+    void Player::sendPacket(ENetPacket *packet, TrafficClass traffic_class)
+    {
+        getChannel().queuePacket(_peer, packet, getChannelId(traffic_class));
+    }
+
+    void Player::sendBoard(
+        ENetPacket *packet, TrafficClass traffic_class, uint64_t player_id, BoardPacket kind)
+    {
+        getChannel().queueBoard(_peer, packet, getChannelId(traffic_class), player_id, kind);
     }
 
     bool Player::handle(GameActionPacket &packet)
@@ -74,12 +177,74 @@ namespace tetriq {
         return true;
     }
 
+    bool Player::handle(GameInputPacket &packet)
+    {
+        const GameInputPacket::Actions &actions = packet.getActions();
+        if (packet.getSequence() < actions.size()) {
+            LogLevel::WARNING << "player " << _network_id << " sent invalid input" << std::endl;
+            return true;
+        }
+        // Packets repeat the actions until they are acknowledged, only the
+        // new ones are applied
+        uint64_t sequence = packet.getSequence() - actions.size();
+        if (sequence > _input_sequence)
+            LogLevel::DEBUG << "player " << _network_id << " lost "
+                            << sequence - _input_sequence << " actions" << std::endl;
+        for (GameAction action : actions) {
+            if (++sequence <= _input_sequence)
+                continue;
+            _game.handleGameAction(action);
+            _applied_actions++;
+        }
+        _input_sequence = std::max(_input_sequence, packet.getSequence());
+        return true;
+    }
+
     bool Player::handle(FullGameRequestPacket &)
     {
-        // TODO : its possible that this packets is handled in the middle of a
-        // tick, we should wait for the end of the tick before sending info.
-        FullGamePacket{_network_id, _game, _applied_actions}.send(_peer);
-        _applied_actions = 0;
+        // Only the requester is out of sync, the others keep the baseline
+        sendBaseline(*this);
+        return true;
+    }
+
+    bool Player::handle(ClientHelloPacket &packet)
+    {
+        if (!_awaiting_hello) {
+            LogLevel::WARNING << "player " << _network_id << " sent an unexpected hello"
+                              << std::endl;
+            return true;
+        }
+        _awaiting_hello = false;
+        WireFormat wire_format = WireFormat::FIXED;
+        for (uint8_t format = LATEST_WIRE_FORMAT; format > 0; format--) {
+            if (packet.getWireFormats() & getWireFormatFlag(static_cast<WireFormat>(format))) {
+                wire_format = static_cast<WireFormat>(format);
+                break;
+            }
+        }
+        const uint64_t version = std::min(packet.getProtocolVersion(), PROTOCOL_VERSION);
+        _capabilities = packet.getCapabilities() & SUPPORTED_CAPABILITIES;
+        // The answer is the last packet sent before switching format
+        const ServerHelloPacket hello{version, wire_format, _capabilities};
+        sendPacket(hello.createENetPacket(WireFormat::FIXED), TrafficClass::GAME);
+        _wire_format = wire_format;
+        // Handed over before the answer is flushed, and the client sends
+        // nothing else until it gets it
+        _server->getNetwork(getChannel().getShard()).setWireFormat(_peer, wire_format);
+        LogLevel::DEBUG << "player " << _network_id << " uses protocol " << version
+                        << ", wire format " << static_cast<int>(wire_format)
+                        << " and capabilities " << _capabilities << std::endl;
+        Channel &channel = getChannel();
+        sendInitGamePacket(channel.getGameConfig());
+        if (!channel.hasGameStarted())
+            return true;
+        // Joining mid-game, the boards are sent after the InitGamePacket on the
+        // same channel so they can't arrive before it
+        for (PlayerHandle handle : channel.getPlayers()) {
+            Player &player = _server->getPlayer(handle);
+            if (player._network_id != _network_id && !player._awaiting_hello)
+                player.sendBaseline(*this);
+        }
         return true;
     }
 
@@ -88,7 +253,7 @@ namespace tetriq {
         if (power_up == BlockType::PU_SWITCH_FIELD) {
             Tetris &targetgame = target.getGame();
             // Don't Swap powerups
-            std::deque<BlockType> tempPowerUps = _game.getPowerUps();
+            PowerUps tempPowerUps = _game.getPowerUps();
             _game.setPowerUps(targetgame.getPowerUps());
             targetgame.setPowerUps(tempPowerUps);
             // Swap boards
@@ -117,7 +282,7 @@ namespace tetriq {
             return true;
         }
         try {
-            Player &target = _channel.getPlayerById(packet.getTarget());
+            Player &target = getChannel().getPlayerById(packet.getTarget());
             Tetris &target_game = target.getGame();
             if (target_game.isOver()) {
                 return true;
@@ -137,22 +302,26 @@ namespace tetriq {
 
     Channel &Player::getChannel()
     {
-        return _channel;
+        return *_server->getChannel(_channel);
     }
 
     bool Player::disconnect()
     {
-        enet_peer_disconnect(_peer, 0);
-        _channel.removePlayer(*this);
+        getChannel().queueDisconnect(_peer);
+        Logger::log(LogLevel::INFO, "player " + std::to_string(_network_id) + " disconnected.");
         return true;
     }
 
     void Player::sendInitGamePacket(const GameConfig &config)
     {
-        std::vector<uint64_t> other_players = _channel.getPlayers();
-        other_players.erase(std::remove(other_players.begin(), other_players.end(), _network_id),
-            other_players.end());
-        InitGamePacket{config.width, config.height, _network_id, other_players}.send(_peer);
+        std::vector<uint64_t> other_players;
+        for (PlayerHandle handle : getChannel().getPlayers()) {
+            const uint64_t id = _server->getPlayer(handle).getNetworkId();
+            if (id != _network_id)
+                other_players.push_back(id);
+        }
+        sendPacket(
+            InitGamePacket{config.width, config.height, _game.getSeed(), _network_id, other_players});
     }
 
     bool Player::isGameOver() const
@@ -7,28 +7,41 @@
 #include "Logger.hpp"
 #include "Messages.hpp"
 #include "ServerConfig.hpp"
-#include "network/PacketHandler.hpp"
+#include "network/TrafficClass.hpp"
+#include "network/packets/ConnectPacket.hpp"
+#include "network/packets/DisconnectPacket.hpp"
 
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
-#include <thread>
-#include <tuple>
+#include <ctime>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <type_traits>
+#include <unistd.h>
 #include <utility>
+#include <variant>
 
 namespace tetriq {
     Server::Server()
         : _address()
-        , _server(nullptr)
-        , _channels({Channel(this, _channel_id_counter)})
         , _rcon(*this)
+        , _tick_pool(_config.tick_threads)
     {
+        for (size_t shard = 0; shard < _config.shards; shard++)
+            _default_channels.push_back(_channels.emplace(this, shard, shard));
+        _channel_id_counter = _channels.size() - 1;
         if (init() == false)
             throw ServerInitException();
     }
 
-    Player &Server::getPlayerById(uint64_t id)
+    Player &Server::getPlayer(PlayerHandle player)
     {
-        return _players.at(id);
+        return _players[player];
     }
 
     const ServerConfig &Server::getConfig() const
@@ -36,30 +49,107 @@ namespace tetriq {
         return _config;
     }
 
-    std::vector<Channel> &Server::getChannels()
+    SlotMap<Channel> &Server::getChannels()
     {
         return _channels;
     }
 
+    Channel *Server::getChannel(ChannelHandle channel)
+    {
+        return _channels.get(channel);
+    }
+
+    ChannelHandle Server::findChannel(uint64_t id)
+    {
+        for (size_t i = 0; i < _channels.size(); i++) {
+            if (_channels.values()[i].getChannelId() == id)
+                return _channels.getHandle(i);
+        }
+        return {};
+    }
+
+    NetworkThread &Server::getNetwork(size_t shard)
+    {
+        return *_networks[shard];
+    }
+
     bool Server::createChannel()
     {
         _channel_id_counter++;
-        _channels.emplace_back(this, _channel_id_counter);
+        _channels.emplace(this, _channel_id_counter, _channel_id_counter % _config.shards);
         return true;
     }
 
     bool Server::deleteChannel(uint64_t id)
     {
-        if (id == 0) {
+        // Default channels of the shards
+        if (id < _config.shards) {
             return false;
         }
-        for (size_t i = 0; i < _channels.size(); i++) {
-            if (_channels[i].getChannelId() == id) {
-                _channels.erase(_channels.begin() + i);
-                return true;
+        const ChannelHandle handle = findChannel(id);
+        Channel *channel = _channels.get(handle);
+        // Players keep a handle to their channel
+        if (channel == nullptr || !channel->getPlayers().empty()) {
+            return false;
+        }
+        channel->flushPackets();
+        // Its game may still be running without players until the next tick
+        std::erase(_active_channels, handle);
+        std::erase(_recorded_channels, handle);
+        _channels.erase(handle);
+        return true;
+    }
+
+    bool Server::startGame(ChannelHandle handle)
+    {
+        Channel *channel = _channels.get(handle);
+        if (channel == nullptr)
+            return false;
+        channel->startGame();
+        _gravity_deadlines.push({channel->getNextGravity(), handle});
+        if (std::find(_active_channels.begin(), _active_channels.end(), handle)
+            == _active_channels.end())
+            _active_channels.push_back(handle);
+        return true;
+    }
+
+    void Server::tickChannels()
+    {
+        const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        while (!_gravity_deadlines.empty() && _gravity_deadlines.top().deadline <= now) {
+            const GravityDeadline due = _gravity_deadlines.top();
+            _gravity_deadlines.pop();
+            Channel *channel = _channels.get(due.channel);
+            // Left over from a game which was stopped or restarted since
+            if (channel == nullptr || !channel->hasGameStarted()
+                || channel->getNextGravity() != due.deadline)
+                continue;
+            _gravity_deadlines.push({channel->scheduleGravity(now), due.channel});
+        }
+        // Players and channels are only added or removed while handling
+        // events, so ticking channels in parallel is safe. The records of the
+        // previous tick are encoded and sent meanwhile.
+        const size_t recorded = _recorded_channels.size();
+        _tick_pool.run(recorded + _active_channels.size(), [this, recorded](size_t i) {
+            if (i >= recorded) {
+                _channels[_active_channels[i - recorded]].tick();
+            } else if (Channel *channel = _channels.get(_recorded_channels[i])) {
+                channel->sendRecords();
             }
+        });
+        for (ChannelHandle handle : _active_channels) {
+            _channels[handle].swapRecords();
         }
-        return false;
+        _recorded_channels = _active_channels;
+        std::erase_if(_active_channels, [this](ChannelHandle handle) {
+            const Channel *channel = _channels.get(handle);
+            return channel == nullptr || !channel->hasGameStarted();
+        });
+    }
+
+    uint64_t Server::generateSeed()
+    {
+        return _seed_generator();
     }
 
     bool Server::init()
@@ -93,44 +183,137 @@ namespace tetriq {
 
     bool Server::createHost()
     {
-        _server = enet_host_create(&_address,
-            _config.max_clients,
-            0,
-            _config.max_incoming_bandwidth,
-            _config.max_outgoing_bandwidth);
-        if (_server == nullptr) {
-            Logger::log(LogLevel::CRITICAL, "An error occurred while creating the enet host.");
-            return false;
+        for (size_t shard = 0; shard < _config.shards; shard++) {
+            ENetHost *host = nullptr;
+            if (_config.shards == 1)
+                host = enet_host_create(&_address,
+                    _config.max_clients,
+                    CHANNEL_COUNT,
+                    _config.max_incoming_bandwidth,
+                    _config.max_outgoing_bandwidth);
+            else
+                host = createSharedHost();
+            if (host == nullptr) {
+                Logger::log(LogLevel::CRITICAL, "An error occurred while creating the enet host.");
+                return false;
+            }
+            _hosts.push_back(host);
         }
-        LogLevel::DEBUG << "Server created with max clients: " << _config.max_clients
+        LogLevel::DEBUG << "Server created with " << _config.shards
+                        << " shards, max clients per shard: " << _config.max_clients
                         << ", max incoming bandwidth: " << _config.max_incoming_bandwidth
                         << ", max outgoing bandwidth: " << _config.max_outgoing_bandwidth
                         << std::endl;
         return true;
     }
 
+    ENetHost *Server::createSharedHost() const
+    {
+        // Created unbound so that the port can be shared before binding it
+        ENetHost *host = enet_host_create(nullptr,
+            _config.max_clients,
+            CHANNEL_COUNT,
+            _config.max_incoming_bandwidth,
+            _config.max_outgoing_bandwidth);
+        if (host == nullptr)
+            return nullptr;
+        const int enable = 1;
+        if (setsockopt(host->socket, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0
+            || enet_socket_bind(host->socket, &_address) != 0) {
+            enet_host_destroy(host);
+            return nullptr;
+        }
+        host->address = _address;
+        return host;
+    }
+
     void Server::listen()
     {
-        _next_tick = std::chrono::steady_clock::now()
-                     + std::chrono::nanoseconds(1'000'000'000 / _config.ticks_per_second);
+        for (ENetHost *host : _hosts)
+            _networks.push_back(std::make_unique<NetworkThread>(host));
+        const int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        const int tick_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+        if (epoll_fd < 0 || tick_fd < 0) {
+            Logger::log(LogLevel::CRITICAL, "An error occurred while creating the event loop.");
+            close(epoll_fd);
+            close(tick_fd);
+            _networks.clear();
+            return;
+        }
+        const uint64_t tick_duration = 1'000'000'000 / _config.ticks_per_second;
+        const timespec tick_interval{static_cast<time_t>(tick_duration / 1'000'000'000),
+            static_cast<long>(tick_duration % 1'000'000'000)};
+        const itimerspec tick_timer{tick_interval, tick_interval};
+        bool ready = timerfd_settime(tick_fd, 0, &tick_timer, nullptr) == 0
+            && addEventSource(epoll_fd, tick_fd, TICK_EVENT);
+        for (size_t shard = 0; ready && shard < _networks.size(); shard++)
+            ready = addEventSource(epoll_fd, _networks[shard]->getEventFd(), NETWORK_EVENT + shard);
+        if (ready && _rcon.getPollFd() >= 0)
+            ready = addEventSource(epoll_fd, _rcon.getPollFd(), RCON_EVENT);
+        if (!ready) {
+            Logger::log(LogLevel::CRITICAL, "An error occurred while setting up the event loop.");
+            close(epoll_fd);
+            close(tick_fd);
+            _networks.clear();
+            return;
+        }
+
+        std::vector<epoll_event> events(NETWORK_EVENT + _networks.size());
         while (not should_exit && _running) {
-            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
-            if (now > _next_tick) {
-                LogLevel::WARNING << "main loop is running behind" << std::endl;
-                _next_tick = std::chrono::steady_clock::now()
-                             + std::chrono::nanoseconds(1'000'000'000 / _config.ticks_per_second);
-            } else {
-                std::this_thread::sleep_until(_next_tick);
-                _next_tick += std::chrono::nanoseconds(1'000'000'000 / _config.ticks_per_second);
+            const int count = epoll_wait(epoll_fd, events.data(), events.size(), -1);
+            if (count < 0) {
+                if (errno == EINTR)
+                    continue;
+                Logger::log(LogLevel::CRITICAL, "An error occurred while waiting for events.");
+                break;
             }
+            bool tick = false;
+            bool rcon = false;
+            for (int i = 0; i < count; i++) {
+                switch (events[i].data.u32) {
+                    case TICK_EVENT: {
+                        uint64_t expirations = 0;
+                        if (read(tick_fd, &expirations, sizeof(expirations)) > 0
+                            && expirations > 1)
+                            LogLevel::WARNING << "main loop is running behind" << std::endl;
+                        tick = true;
+                        break;
+                    }
+                    case RCON_EVENT:
+                        rcon = true;
+                        break;
+                    default:
+                        _networks[events[i].data.u32 - NETWORK_EVENT]->acknowledgeEvents();
+                        break;
+                }
+            }
+            // Incoming packets are handled as soon as they arrive, not on the
+            // next tick
             if (!handleENetEvents())
                 break;
-            if (!handleRconEvents())
+            // Rcon answers are only written on the call after the command
+            if ((rcon || tick) && !handleRconEvents())
                 break;
+            if (tick)
+                tickChannels();
             for (Channel &channel : _channels) {
-                channel.tick();
+                channel.flushPackets();
+            }
+            for (std::unique_ptr<NetworkThread> &network : _networks) {
+                network->flush();
             }
         }
+        close(epoll_fd);
+        close(tick_fd);
+        _networks.clear();
+    }
+
+    bool Server::addEventSource(int epoll_fd, int fd, uint32_t source)
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u32 = source;
+        return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
     }
 
     bool Server::handleRconEvents()
@@ -143,71 +326,119 @@ namespace tetriq {
 
     bool Server::handleENetEvents()
     {
-        ENetEvent event;
-        while (enet_host_service(_server, &event, 0) > 0) {
-            switch (event.type) {
-                case ENET_EVENT_TYPE_CONNECT:
-                    handleNewClient(event);
-                    break;
-                case ENET_EVENT_TYPE_DISCONNECT:
-                    handleClientDisconnect(event);
-                    break;
-                case ENET_EVENT_TYPE_RECEIVE:
-                    handleClientPacket(event);
-                    break;
-                case ENET_EVENT_TYPE_NONE:
-                    handleNone(event);
-                    break;
+        NetworkEvent event;
+        for (size_t shard = 0; shard < _networks.size(); shard++) {
+            while (_networks[shard]->pollEvent(event)) {
+                switch (event.type) {
+                    case ENET_EVENT_TYPE_CONNECT:
+                        handleNewClient(event, shard);
+                        break;
+                    case ENET_EVENT_TYPE_DISCONNECT:
+                        handleClientDisconnect(event, shard);
+                        break;
+                    case ENET_EVENT_TYPE_RECEIVE:
+                        handleClientPacket(event);
+                        break;
+                    case ENET_EVENT_TYPE_NONE:
+                        handleNone(event);
+                        break;
+                }
             }
         }
         return true;
     }
 
-    bool Server::handleNewClient(ENetEvent &event)
+    bool Server::handleNewClient(NetworkEvent &event, size_t shard)
     {
-        event.peer->data = new uint64_t(_network_id_counter);
-        _channels.front().broadcastPacket(
-            ConnectPacket(_network_id_counter, _config.game.width, _config.game.height));
-        _players.emplace(std::piecewise_construct,
-            std::forward_as_tuple(_network_id_counter),
-            std::forward_as_tuple(_network_id_counter, event.peer, _channels.front()));
-        Player &player = _players.at(_network_id_counter);
-        player.sendInitGamePacket(_config.game);
-        player.setGameOver(true);
+        // Clients from before handshakes connect with no protocol version,
+        // and can't decode the packets anymore
+        if (event.data == 0) {
+            LogLevel::WARNING << "rejected a client without protocol version" << std::endl;
+            event.peer->data = nullptr;
+            _networks[shard]->disconnect(event.peer);
+            return false;
+        }
+        // ENet refuses to send on channels the peer didn't ask for
+        if (event.peer->channelCount < CHANNEL_COUNT) {
+            LogLevel::WARNING << "rejected a client with " << event.peer->channelCount
+                              << " channels" << std::endl;
+            event.peer->data = nullptr;
+            _networks[shard]->disconnect(event.peer);
+            return false;
+        }
+        // Players can only join channels of the shard they are connected to
+        const ChannelHandle channel_handle = _default_channels[shard];
+        Channel &channel = _channels[channel_handle];
+        channel.broadcastBoard(
+            ConnectPacket(_network_id_counter, _config.game.width, _config.game.height),
+            _network_id_counter,
+            BoardPacket::CONNECT);
+        const PlayerHandle handle =
+            _players.emplace(this, _network_id_counter, event.peer, channel_handle);
+        event.peer->data = handle.toPointer();
+        // Network ids are unique so no way the player was already added
+        [[maybe_unused]] const bool added = channel.addPlayer(handle);
+        assert(added);
+        // Its game is sent once the handshake is done
+        _players[handle].setGameOver(true);
         // TODO : choose a channel intelligently and dont start game instantly
         _network_id_counter++;
         return true;
     }
 
-    void Server::handleClientDisconnect(ENetEvent &event)
+    void Server::handleClientDisconnect(NetworkEvent &event, size_t shard)
     {
-        uint64_t network_id = *(uint64_t *) event.peer->data;
-        Player &player = _players.at(network_id);
+        // Rejected on connection
+        if (event.peer->data == nullptr) {
+            _networks[shard]->release(event.peer);
+            return;
+        }
+        const PlayerHandle handle = PlayerHandle::fromPointer(event.peer->data);
+        Player &player = _players[handle];
+        const uint64_t network_id = player.getNetworkId();
         Channel &channel = player.getChannel();
         player.disconnect();
-        _players.erase(network_id);
-        delete (uint64_t *) event.peer->data;
+        // Everything queued for the old client must be handed to the network
+        // before the peer can be used by a new one
+        channel.flushPackets();
+        _networks[shard]->release(event.peer);
+        channel.removePlayer(handle);
+        _players.erase(handle);
         event.peer->data = nullptr;
-        channel.broadcastPacket(DisconnectPacket(network_id));
+        channel.broadcastBoard(DisconnectPacket(network_id), network_id, BoardPacket::DISCONNECT);
     }
 
-    void Server::handleClientPacket(ENetEvent &event)
+    void Server::handleClientPacket(NetworkEvent &event)
     {
-        uint64_t network_id = *(uint64_t *) event.peer->data;
-        Player &player = _players.at(network_id);
-        /*Channel &channel = player.getChannel();*/
+        // Rejected on connection
+        if (event.peer->data == nullptr)
+            return;
+        Player &player = _players[PlayerHandle::fromPointer(event.peer->data)];
 
-        PacketHandler::decodePacket(event, {&player});
+        const bool handled = std::visit(
+            [&player](auto &packet) {
+                if constexpr (std::is_same_v<std::decay_t<decltype(packet)>, std::monostate>)
+                    return false;
+                else
+                    return player.handle(packet);
+            },
+            event.packet);
+        if (!handled)
+            LogLevel::WARNING << "player " << player.getNetworkId() << " sent an invalid packet"
+                              << std::endl;
     }
 
-    void Server::handleNone([[maybe_unused]] ENetEvent &event) const
+    void Server::handleNone([[maybe_unused]] NetworkEvent &event) const
     {
         // Logger::log(LogLevel::DEBUG, "No event occurred");
     }
 
     Server::~Server()
     {
-        enet_host_destroy(_server);
+        _networks.clear();
+        for (ENetHost *host : _hosts) {
+            enet_host_destroy(host);
+        }
         enet_deinitialize();
         Logger::log(LogLevel::INFO, ENET_DEINIT_SUCCESS);
         Logger::log(LogLevel::INFO, "Server stopped");
@@ -5,6 +5,8 @@
 #include "ServerConfig.hpp"
 #include "GameConfig.hpp"
 
+#include <algorithm>
+
 tetriq::ServerConfig::ServerConfig(const std::string &config_name)
     : AConfig(config_name)
 {
@@ -17,6 +19,8 @@ tetriq::ServerConfig::ServerConfig(const std::string &config_name)
     listen_address = _table["listen_address"].value_or(this->listen_address);
     listen_port = _table["listen_port"].value<int64_t>().value_or(this->listen_port);
     ticks_per_second = _table["ticks_per_second"].value<int64_t>().value_or(this->ticks_per_second);
+    tick_threads = _table["tick_threads"].value<int64_t>().value_or(this->tick_threads);
+    shards = std::max<int64_t>(_table["shards"].value<int64_t>().value_or(this->shards), 1);
     if (_table["game"].is_table())
         game = GameConfig{*_table["game"].as_table()};
     if (_table["rcon"].is_table())
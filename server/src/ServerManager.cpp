@@ -16,24 +16,29 @@ tetriq::ServerManager::ServerManager(Server &server)
 
 tetriq::ServerManager::~ServerManager() = default;
 
+tetriq::Channel *tetriq::ServerManager::getSelectedChannel()
+{
+    return _server.getChannel(_selected_channel);
+}
+
 void tetriq::ServerManager::_startGame(
     const std::vector<std::string> &, std::queue<std::string> &res_queue)
 {
-    if (_selected_channel == nullptr) {
+    if (!_server.startGame(_selected_channel)) {
         res_queue.emplace("RCON: No channel selected\n");
         return;
     }
-    _selected_channel->startGame();
     res_queue.emplace("RCON: Game started\n");
 }
 
 void tetriq::ServerManager::_stopGame(_args, std::queue<std::string> &res_queue)
 {
-    if (_selected_channel == nullptr) {
+    Channel *channel = getSelectedChannel();
+    if (channel == nullptr) {
         res_queue.emplace("RCON: No channel selected\n");
         return;
     }
-    _selected_channel->stopGame();
+    channel->stopGame();
     res_queue.emplace("RCON: Game stopped\n");
 }
 
@@ -56,10 +61,11 @@ void tetriq::ServerManager::_set(
         }
         try {
             uint64_t channel_id = std::stoul(args[1]);
-            if (channel_id >= _server.getChannels().size()) {
+            const ChannelHandle channel = _server.findChannel(channel_id);
+            if (_server.getChannel(channel) == nullptr) {
                 throw std::out_of_range("Channel not found");
             }
-            _selected_channel = &_server.getChannels()[channel_id];
+            _selected_channel = channel;
             res_queue.emplace("RCON: Channel " + std::to_string(channel_id) + " selected\n");
             return;
         } catch (const std::invalid_argument &e) {
@@ -104,11 +110,12 @@ void tetriq::ServerManager::_create(
 
 void tetriq::ServerManager::_delete(_args, std::queue<std::string> &res_queue)
 {
-    if (_selected_channel == nullptr) {
+    Channel *channel = getSelectedChannel();
+    if (channel == nullptr) {
         res_queue.emplace("RCON: No channel selected\n");
         return;
     }
-    if (_server.deleteChannel(_selected_channel->getChannelId())) {
+    if (_server.deleteChannel(channel->getChannelId())) {
         res_queue.emplace("RCON: Channel deleted\n");
     } else {
         res_queue.emplace("RCON: Channel deletion failed\n");
@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+#include "WorkerPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace tetriq {
+    WorkerPool::WorkerPool(size_t threads)
+        : _ranges(threads == 0 ? 1 : threads)
+    {
+        // The thread calling run() is the first worker
+        for (size_t i = 1; i < _ranges.size(); i++)
+            _threads.emplace_back(&WorkerPool::workerLoop, this, i);
+    }
+
+    WorkerPool::~WorkerPool()
+    {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _start_cv.notify_all();
+        for (std::thread &thread : _threads)
+            thread.join();
+    }
+
+    void WorkerPool::run(size_t count, const std::function<void(size_t)> &task)
+    {
+        if (count == 0)
+            return;
+        if (_threads.empty()) {
+            for (size_t i = 0; i < count; i++)
+                task(i);
+            return;
+        }
+        {
+            std::lock_guard lock(_mutex);
+            _task = &task;
+            _remaining = count;
+            for (size_t i = 0; i < _ranges.size(); i++) {
+                std::lock_guard range_lock(_ranges[i].mutex);
+                _ranges[i].begin = count * i / _ranges.size();
+                _ranges[i].end = count * (i + 1) / _ranges.size();
+            }
+            _generation++;
+        }
+        _start_cv.notify_all();
+        work(0);
+        std::unique_lock lock(_mutex);
+        _done_cv.wait(lock, [this] { return _remaining == 0; });
+        _task = nullptr;
+    }
+
+    void WorkerPool::workerLoop(size_t index)
+    {
+        uint64_t generation = 0;
+
+        while (true) {
+            {
+                std::unique_lock lock(_mutex);
+                _start_cv.wait(lock, [&] { return _stopping || _generation != generation; });
+                if (_stopping)
+                    return;
+                generation = _generation;
+            }
+            work(index);
+        }
+    }
+
+    void WorkerPool::work(size_t index)
+    {
+        size_t done = 0;
+        size_t task;
+
+        while (popTask(index, task) || stealTask(index, task)) {
+            (*_task)(task);
+            done++;
+        }
+        if (done == 0)
+            return;
+        std::lock_guard lock(_mutex);
+        _remaining -= done;
+        if (_remaining == 0)
+            _done_cv.notify_one();
+    }
+
+    bool WorkerPool::popTask(size_t index, size_t &task)
+    {
+        TaskRange &range = _ranges[index];
+        std::lock_guard lock(range.mutex);
+        if (range.begin == range.end)
+            return false;
+        task = range.begin++;
+        return true;
+    }
+
+    bool WorkerPool::stealTask(size_t index, size_t &task)
+    {
+        for (size_t i = 1; i < _ranges.size(); i++) {
+            TaskRange &range = _ranges[(index + i) % _ranges.size()];
+            std::lock_guard lock(range.mutex);
+            if (range.begin == range.end)
+                continue;
+            task = --range.end;
+            return true;
+        }
+        return false;
+    }
+}
@@ -7,6 +7,8 @@
 #include "Logger.hpp"
 #include "Server.hpp"
 
+#include <sys/epoll.h>
+
 tetriq::RconClient::RconClient(int socket, sockaddr_in address)
     : _socket(socket)
     , _address(address)
@@ -73,6 +75,8 @@ tetriq::Rcon::~Rcon()
     }
     _is_running = false;
     close(_rcon_socket);
+    if (_epoll_fd >= 0)
+        close(_epoll_fd);
     RCONLOG(INFO) << "Rcon destroyed" << std::endl;
 }
 
@@ -93,6 +97,9 @@ void tetriq::Rcon::handleNewClient()
             return;
         }
         _client = std::make_unique<RconClient>(new_client_socket, new_client_addr);
+        // Closing the socket removes it from the epoll set
+        epoll_event event{EPOLLIN, {.fd = new_client_socket}};
+        epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, new_client_socket, &event);
         *_client << "RCON: Enter password\n";
         RCONLOG(INFO) << "New connection" << std::endl;
     }
@@ -217,6 +224,11 @@ bool tetriq::Rcon::init()
     return true;
 }
 
+int tetriq::Rcon::getPollFd() const
+{
+    return _is_running ? _epoll_fd : -1;
+}
+
 void tetriq::Rcon::registerCommand(const std::string &commandName,
     void (ServerManager::*func)(const std::vector<std::string> &, std::queue<std::string> &))
 {
@@ -263,6 +275,13 @@ bool tetriq::Rcon::createHost()
         RCONLOG(ERROR) << "Failed to listen" << std::endl;
         return false;
     }
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (_epoll_fd < 0) {
+        RCONLOG(ERROR) << "Failed to create epoll instance" << std::endl;
+        return false;
+    }
+    epoll_event event{EPOLLIN, {.fd = _rcon_socket}};
+    epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, _rcon_socket, &event);
     RCONLOG(INFO) << "Server listening on " << _config.listen_address << ":" << _config.listen_port
                   << std::endl;
     return true;
@@ -0,0 +1,98 @@
+// SPDX-FileCopyrightText: 2024 The TetriQ authors
+//
+// SPDX-License-Identifier: AGPL-3.0-or-later
+
+/**
+ * Fails if ticking a game allocates once it is warmed up, so that channels
+ * ticked in parallel never contend on the allocator.
+ */
+
+#include "Block.hpp"
+#include "GameAction.hpp"
+#include "Logger.hpp"
+#include "Tetris.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+static size_t allocations = 0;
+
+void *operator new(size_t size)
+{
+    allocations++;
+    void *ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+int main()
+{
+    using namespace tetriq;
+
+    constexpr std::array POWER_UPS{BlockType::PU_ADD_LINE,
+        BlockType::PU_CLEAR_LINE,
+        BlockType::PU_CLEAR_SPECIAL_BLOCK,
+        BlockType::PU_CLEAR_BLOCK_RANDOM,
+        BlockType::PU_GRAVITY,
+        BlockType::PU_NUKE_FIELD,
+        BlockType::PU_COLUMN_SHUFFLE};
+    constexpr size_t TICKS = 100'000;
+
+    Logger::setLogVisibility(false);
+    Tetris game(12, 22, 42);
+    // Statics and lazily built tables are allowed to allocate once
+    for (BlockType power_up : POWER_UPS) {
+        game.applyPowerUp(power_up);
+    }
+    game.tick();
+
+    uint64_t state = 1;
+    const size_t before = allocations;
+    for (size_t i = 0; i < TICKS; i++) {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        if (game.isOver()) {
+            game.applyPowerUp(BlockType::PU_NUKE_FIELD);
+            game.setGameOver(false);
+        }
+        game.handleGameAction(static_cast<GameAction>((state >> 33) % 5));
+        if (i % 7 == 0)
+            game.applyPowerUp(POWER_UPS[(state >> 40) % POWER_UPS.size()]);
+        game.consumePowerUp();
+        game.tick();
+    }
+    const size_t allocated = allocations - before;
+    if (allocated != 0) {
+        std::cerr << allocated << " allocations during " << TICKS << " ticks" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}